@@ -8,5 +8,6 @@
 //#include "index_wcsearch_bfs.hpp"
 //#include "index_dbsearch.hpp"
 #include "index_sasearch.hpp"
+#include "index_vlg.hpp"
 //#include "index_bstree.hpp"
 #include "index_qgram_regexp.hpp"
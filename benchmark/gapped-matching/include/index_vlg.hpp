@@ -0,0 +1,122 @@
+#pragma once
+
+#include "utils.hpp"
+#include "collection.hpp"
+#include "sdsl/vlg_index.hpp"
+#include <type_traits>
+
+// Engines executing the queries of index_vlg.
+enum class vlg_engine {
+    iterator, // depth-first vlg_iterator
+    level,    // level-synchronous vlg_level_engine
+    planner   // cost-based choice between wavelet tree traversal, SA merge and text scan
+};
+
+// Benchmark wrapper of sdsl::vlg_index.
+template<class t_wt, vlg_engine t_engine=vlg_engine::iterator>
+class index_vlg
+{
+    private:
+        typedef sdsl::vlg_index<sdsl::int_alphabet_tag, t_wt> index_type;
+        index_type index;
+        sdsl::vlg_expansion expansion = sdsl::vlg_expansion::largest_node;
+
+        typename index_type::query_type make_query(const gapped_pattern& pat) const
+        {
+            typename index_type::query_type query;
+            for (size_t i = 0; i < pat.subpatterns.size(); ++i) {
+                const auto& s = pat.subpatterns[i];
+                typename index_type::query_type::string_type subpattern(s.size());
+                std::copy(s.begin(), s.end(), subpattern.begin());
+                query.subpatterns.push_back(subpattern);
+                if (i < pat.gaps.size())
+                    query.gaps.emplace_back(pat.gaps[i].first + s.size(), pat.gaps[i].second + s.size());
+            }
+            return query;
+        }
+
+    public:
+        typedef typename index_type::size_type size_type;
+        std::string name() const
+        {
+            std::string index_name = IDXNAME;
+            return "VLG-"+index_name;
+        }
+
+    public:
+        index_vlg() { }
+        index_vlg(collection& col)
+        {
+            sdsl::cache_config cc(false,".","VLG_TMP");
+            construct(index, col.file_map[consts::KEY_TEXT], cc, 0);
+        }
+
+        size_type serialize(std::ostream& out, sdsl::structure_tree_node* v=NULL, std::string name="")const
+        {
+            return index.serialize(out, v, name);
+        }
+
+        void load(std::istream& in)
+        {
+            index.load(in);
+        }
+
+        void swap(index_vlg& ir)
+        {
+            if (this != &ir) {
+                index.swap(ir.index);
+            }
+        }
+
+        // Selects the expansion policy of the iterator engine by its name (see sdsl::expansion_name).
+        // The other engines do not expand walkers, so they do not provide this method.
+        template<vlg_engine t_e=t_engine>
+        typename std::enable_if<t_e == vlg_engine::iterator>::type
+        set_expansion(const std::string& name)
+        {
+            for (auto e : {sdsl::vlg_expansion::largest_node, sdsl::vlg_expansion::rarest_anchor,
+                           sdsl::vlg_expansion::gap_slack}) {
+                if (name == sdsl::expansion_name(e)) {
+                    expansion = e;
+                    return;
+                }
+            }
+            throw std::invalid_argument("unknown expansion policy: " + name);
+        }
+
+        // Reports the strategy the planner chooses for the pattern.
+        std::string info(const gapped_pattern& pat) const
+        {
+            if (t_engine != vlg_engine::planner)
+                return "";
+            sdsl::vlg_planner<index_type> planner(index);
+            return sdsl::strategy_name(planner.plan(make_query(pat)).strategy);
+        }
+        void prepare(const gapped_pattern& pat) { (void)pat; }
+
+        gapped_search_result
+        search(const gapped_pattern& pat) const
+        {
+            gapped_search_result res;
+            auto query = make_query(pat);
+
+            if (t_engine == vlg_engine::level) {
+                sdsl::vlg_level_engine<index_type> engine(index);
+                for (const auto& match : engine.locate(query))
+                    res.positions.push_back(match[0]);
+            } else if (t_engine == vlg_engine::planner) {
+                sdsl::vlg_planner<index_type> planner(index);
+                for (const auto& match : planner.locate(query))
+                    res.positions.push_back(match[0]);
+            } else {
+                sdsl::vlg_query_context<index_type> context;
+                context.set_expansion(expansion);
+                sdsl::locate(index, query, context, std::back_inserter(res.positions));
+            }
+            return res;
+        }
+};
+
+typedef index_vlg<sdsl::wm_int<sdsl::bit_vector_il<>, sdsl::rank_support_il<>>>       index_vlg_wm;
+typedef index_vlg<sdsl::wm_int<sdsl::bit_vector_il<>, sdsl::rank_support_il<>>, vlg_engine::level> index_vlg_wm_level;
+typedef index_vlg<sdsl::wt_int<sdsl::bit_vector_il<>, sdsl::rank_support_il<>>, vlg_engine::planner> index_vlg_planner;
@@ -21,15 +21,17 @@ typedef struct cmdargs {
     std::string collection_dir;
     std::string pattern_file;
     bool string_patterns;
+    std::string expansion;
 } cmdargs_t;
 
 void print_usage(const char* program)
 {
-    fprintf(stdout, "%s -c <collection dir> -p <pattern file> [-t <string patterns>]\n", program);
+    fprintf(stdout, "%s -c <collection dir> -p <pattern file> [-t <string patterns>] [-e <expansion policy>]\n", program);
     fprintf(stdout, "where\n");
     fprintf(stdout, "  -c <collection dir>  : the collection dir.\n");
     fprintf(stdout, "  -p <pattern file>    : the pattern file.\n");
     fprintf(stdout, "  -t <string patterns> : Whether the patterns are regular char-strings. (default: 1)\n");
+    fprintf(stdout, "  -e <expansion policy>: Expansion policy of VLG indexes: largest_node, rarest_anchor or gap_slack.\n");
 };
 
 cmdargs_t parse_args(int argc, const char* argv[])
@@ -38,7 +40,7 @@ cmdargs_t parse_args(int argc, const char* argv[])
     int op;
     args.collection_dir = "";
     args.string_patterns = true;
-    while ((op = getopt(argc, (char* const*)argv, "c:p:t:")) != -1) {
+    while ((op = getopt(argc, (char* const*)argv, "c:p:t:e:")) != -1) {
         switch (op) {
             case 'c':
                 args.collection_dir = optarg;
@@ -49,6 +51,9 @@ cmdargs_t parse_args(int argc, const char* argv[])
             case 't':
                 args.string_patterns = std::string(optarg) == "1";
                 break;
+            case 'e':
+                args.expansion = optarg;
+                break;
         }
     }
     if (args.collection_dir == ""||args.pattern_file == "") {
@@ -59,8 +64,21 @@ cmdargs_t parse_args(int argc, const char* argv[])
     return args;
 }
 
+// Selects the expansion policy of indexes supporting it.
+template <class t_idx>
+auto set_expansion(t_idx& idx, const std::string& expansion, int) -> decltype(idx.set_expansion(expansion), void())
+{
+    idx.set_expansion(expansion);
+}
+
 template <class t_idx>
-void bench_index(collection& col,const std::vector<gapped_pattern>& patterns)
+void set_expansion(t_idx& idx, const std::string&, long)
+{
+    LOG(FATAL) << "index " << idx.name() << " does not support expansion policies";
+}
+
+template <class t_idx>
+void bench_index(collection& col,const std::vector<gapped_pattern>& patterns,const std::string& expansion)
 {
     mem_monitor mm("mem-mon-out.csv",std::chrono::milliseconds(10));
     LIKWID_MARKER_INIT;
@@ -78,6 +96,10 @@ void bench_index(collection& col,const std::vector<gapped_pattern>& patterns)
         LOG(FATAL) << "cannot read index from file : " << input_file;
     }
     LIKWID_MARKER_STOP("load");
+    if (expansion != "") {
+        set_expansion(idx, expansion, 0);
+        LOG(INFO) << "EXPANSION = " << expansion;
+    }
 
     mm.event("search");
     LIKWID_MARKER_START("search");
@@ -177,7 +199,7 @@ int main(int argc, const char* argv[])
     /* create index */
     {
         using index_type = INDEX_TYPE;
-        bench_index<index_type>(col,patterns);
+        bench_index<index_type>(col,patterns,args.expansion);
     }
 
     return 0;
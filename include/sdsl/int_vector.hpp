@@ -325,6 +325,7 @@ class int_vector
         size_type      m_size;  //!< Number of bits needed to store int_vector.
         uint64_t*      m_data;  //!< Pointer to the memory for the bits.
         int_width_type m_width; //!< Width of the integers.
+        bool           m_mapped = false; //!< Whether m_data points into a file mapping (see load_from_mapped_file).
 
     public:
 
@@ -1249,10 +1250,11 @@ inline int_vector<t_width>::int_vector(size_type size, value_type default_value,
 
 template<uint8_t t_width>
 inline int_vector<t_width>::int_vector(int_vector&& v) :
-    m_size(v.m_size), m_data(v.m_data), m_width(v.m_width)
+    m_size(v.m_size), m_data(v.m_data), m_width(v.m_width), m_mapped(v.m_mapped)
 {
     v.m_data = nullptr; // ownership of v.m_data now transfered
     v.m_size = 0;
+    v.m_mapped = false;
 }
 
 template<uint8_t t_width>
@@ -1310,6 +1312,7 @@ void int_vector<t_width>::swap(int_vector& v)
         v.m_size = size;
         v.m_data = data;
         v.width(int_width);
+        std::swap(m_mapped, v.m_mapped);
     }
 }
 
@@ -1534,7 +1537,18 @@ typename int_vector<t_width>::size_type int_vector<t_width>::serialize(std::ostr
     } else {
         written_bytes += int_vector<t_width>::write_header(m_size, m_width, out);
     }
-    written_bytes += write_data(out);
+    if (out.iword(memory_manager::mapped_stream_index())) {
+        // align the data and append a zero word (see memory_manager::mapped_stream_index)
+        uint64_t offset = out.tellp();
+        uint64_t padding = memory_manager::mapped_data_offset(offset, capacity()>>3) - offset;
+        const char zeros[4096] = {};
+        out.write(zeros, padding);
+        written_bytes += write_data(out);
+        out.write(zeros, sizeof(uint64_t));
+        written_bytes += padding + sizeof(uint64_t);
+    } else {
+        written_bytes += write_data(out);
+    }
     structure_tree::add_size(child, written_bytes);
     return written_bytes;
 }
@@ -1545,6 +1559,17 @@ void int_vector<t_width>::load(std::istream& in)
     size_type size;
     int_vector<t_width>::read_header(size, m_width, in);
 
+    if (in.iword(memory_manager::mapped_stream_index())) {
+        // point into the mapped file instead of copying the data
+        uint64_t offset = memory_manager::mapped_data_offset(in.tellg(), ((size+63)>>6)<<3);
+        memory_manager::clear(*this);
+        m_size = size;
+        m_data = (uint64_t*)((const uint8_t*)in.pword(memory_manager::mapped_stream_index()) + offset);
+        memory_manager::acquire_mapping(m_data);
+        m_mapped = true;
+        in.seekg(offset + (capacity()>>3) + sizeof(uint64_t));
+        return;
+    }
     bit_resize(size);
     uint64_t* p = m_data;
     size_type idx = 0;
@@ -24,6 +24,7 @@
 #include "util.hpp"
 #include "sdsl_concepts.hpp"
 #include "structure_tree.hpp"
+#include "memory_management.hpp"
 #include <algorithm>
 #include <string>
 #include <vector>
@@ -271,6 +272,28 @@ bool store_to_file(const char* v, const std::string& file);
 template<uint8_t t_width>
 bool store_to_file(const int_vector<t_width>& v, const std::string& file, bool write_fixed_as_variable=false);
 
+//! Store a data structure to a file which can be loaded by load_from_mapped_file.
+/*! The data of each int_vector is stored at an aligned offset, where data spanning
+ *  at least a page starts at a page boundary.
+ *  \param v Data structure to store.
+ *  \param file Name of the file where to store the data structure.
+ *  \param Return if the data structure was stored successfully
+ */
+template<class T>
+bool store_to_mapped_file(const T& v, const std::string& file);
+
+//! Load a data structure stored by store_to_mapped_file without copying the int_vector data.
+/*! The file is mapped into memory and the int_vectors of v point into the mapping, so
+ *  processes loading the same file share its pages. The mapping is released when the
+ *  last int_vector pointing into it is destroyed. The mapping is copy-on-write: a
+ *  modified page becomes private to the process, and the file is never changed.
+ *  An int_vector is copied to memory when it is resized.
+ *  \param v Data structure to load.
+ *  \param file Name of the file.
+ */
+template<class T>
+bool load_from_mapped_file(T& v, const std::string& file);
+
 
 //! Store an int_vector as plain int_type array to disk
 template<class int_type, class t_int_vec>
@@ -776,6 +799,49 @@ bool load_from_checked_file(T& v, const std::string& file)
     return load_from_file(v, file);
 }
 
+template<class T>
+bool store_to_mapped_file(const T& v, const std::string& file)
+{
+    std::ofstream out(file, std::ios::binary | std::ios::trunc | std::ios::out);
+    if (!out) {
+        if (util::verbose) {
+            std::cerr<<"ERROR: store_to_mapped_file not successful for: `"<<file<<"`"<<std::endl;
+        }
+        return false;
+    }
+    out.iword(memory_manager::mapped_stream_index()) = 1;
+    serialize(v, out);
+    out.close();
+    if (util::verbose) {
+        std::cerr<<"INFO: store_to_mapped_file: `"<<file<<"`"<<std::endl;
+    }
+    return (bool)out;
+}
+
+template<class T>
+bool load_from_mapped_file(T& v, const std::string& file)
+{
+    uint64_t size = 0;
+    const uint8_t* map = memory_manager::map_file(file, size);
+    std::ifstream in(file, std::ios::binary | std::ios::in);
+    if (map == nullptr or !in) {
+        if (util::verbose) {
+            std::cerr << "Could not map file `" << file << "`" << std::endl;
+        }
+        memory_manager::release_mapping(map);
+        return false;
+    }
+    // the stream provides the remaining members, the mapping the int_vector data
+    in.iword(memory_manager::mapped_stream_index()) = 1;
+    in.pword(memory_manager::mapped_stream_index()) = (void*)map;
+    load(v, in);
+    memory_manager::release_mapping(map);
+    if (util::verbose) {
+        std::cerr << "Map file `" << file << "`" << std::endl;
+    }
+    return (bool)in;
+}
+
 
 template<class t_iv>
 inline typename std::enable_if<
@@ -287,12 +287,29 @@ class memory_manager
 {
     private:
         bool hugepages = false;
+        // file mappings int_vectors may point into (see load_from_mapped_file), with the
+        // number of references to each mapping
+        struct mapping {
+            uint64_t size;
+            uint64_t references;
+        };
+        std::map<const uint8_t*, mapping> mappings;
+        std::mutex                        mappings_mutex;
     private:
         static memory_manager& the_manager()
         {
             static memory_manager m;
             return m;
         }
+        // Returns the mapping containing ptr (mappings.end() if there is none). Requires the lock.
+        std::map<const uint8_t*, mapping>::iterator find_mapping(const void* ptr)
+        {
+            auto it = mappings.upper_bound((const uint8_t*)ptr);
+            if (it == mappings.begin())
+                return mappings.end();
+            --it;
+            return (const uint8_t*)ptr < it->first + it->second.size ? it : mappings.end();
+        }
     public:
         static uint64_t* alloc_mem(size_t size_in_bytes)
         {
@@ -341,6 +358,18 @@ class memory_manager
         {
             uint64_t old_size_in_bytes = ((v.m_size + 63) >> 6) << 3;
             uint64_t new_size_in_bytes = ((size + 63) >> 6) << 3;
+            if (v.m_mapped) {
+                // the mapping can not be reallocated => continue with a copy
+                uint64_t* data = alloc_mem(old_size_in_bytes + 8);
+                if (data == nullptr) {
+                    throw std::bad_alloc();
+                }
+                memcpy(data, v.m_data, old_size_in_bytes);
+                release_mapping(v.m_data);
+                v.m_data = data;
+                v.m_mapped = false;
+                memory_monitor::record(old_size_in_bytes);
+            }
             bool do_realloc = old_size_in_bytes != new_size_in_bytes;
             v.m_size = size;
             if (do_realloc || v.m_data == nullptr) {
@@ -373,6 +402,12 @@ class memory_manager
         static void clear(t_vec& v)
         {
             int64_t size_in_bytes = ((v.m_size + 63) >> 6) << 3;
+            if (v.m_mapped) {
+                release_mapping(v.m_data);
+                v.m_data = nullptr;
+                v.m_mapped = false;
+                return;
+            }
             // remove mem
             memory_manager::free_mem(v.m_data);
             v.m_data = nullptr;
@@ -383,6 +418,110 @@ class memory_manager
             }
         }
 
+        //! Maps a file copy-on-write into memory, holding one reference to the mapping.
+        /*!
+         * \param filename  File to map.
+         * \param size      Is set to the size of the file in bytes.
+         * \return The address of the mapping or nullptr if the file could not be mapped.
+         *
+         * Pages are shared with the page cache until they are written to; writes
+         * are private to the process and never reach the file.
+         * Further references are acquired by int_vectors pointing into the mapping
+         * (see load_from_mapped_file). The file is unmapped as soon as the last
+         * reference is released.
+         */
+        static const uint8_t* map_file(std::string filename, uint64_t& size)
+        {
+            size = util::file_size(filename);
+            int fd = open_file_for_mmap(filename, std::ios_base::in);
+            if (fd == -1) {
+                return nullptr;
+            }
+            void* map = nullptr;
+            if (size) { // an empty file can not be mapped
+#ifdef MSVC_COMPILER
+                HANDLE fm = CreateFileMapping((HANDLE)_get_osfhandle(fd), NULL, PAGE_WRITECOPY, 0, 0, NULL);
+                if (fm != NULL) {
+                    map = MapViewOfFile(fm, FILE_MAP_COPY, 0, 0, size);
+                    CloseHandle(fm);
+                }
+#else
+                map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+                if (map == MAP_FAILED) map = nullptr;
+#endif
+            }
+            close_file_for_mmap(fd);
+            if (map != nullptr) {
+                auto& m = the_manager();
+                std::lock_guard<std::mutex> lock(m.mappings_mutex);
+                m.mappings[(const uint8_t*)map] = {size, 1};
+            }
+            return (const uint8_t*)map;
+        }
+
+        //! Returns whether ptr points into a file mapped by map_file.
+        static bool is_mapped(const void* ptr)
+        {
+            auto& m = the_manager();
+            std::lock_guard<std::mutex> lock(m.mappings_mutex);
+            return m.find_mapping(ptr) != m.mappings.end();
+        }
+
+        //! Acquires a reference to the mapping ptr points into.
+        static void acquire_mapping(const void* ptr)
+        {
+            auto& m = the_manager();
+            std::lock_guard<std::mutex> lock(m.mappings_mutex);
+            auto it = m.find_mapping(ptr);
+            if (it != m.mappings.end()) {
+                ++it->second.references;
+            }
+        }
+
+        //! Releases a reference to the mapping ptr points into.
+        /*!
+         * \return Whether ptr points into a mapping.
+         */
+        static bool release_mapping(const void* ptr)
+        {
+            auto& m = the_manager();
+            std::lock_guard<std::mutex> lock(m.mappings_mutex);
+            auto it = m.find_mapping(ptr);
+            if (it == m.mappings.end()) {
+                return false;
+            }
+            if (--it->second.references == 0) {
+                mem_unmap((void*)it->first, it->second.size);
+                m.mappings.erase(it);
+            }
+            return true;
+        }
+
+        //! Index of the stream word (see std::ios_base::iword) marking streams written by
+        //! store_to_mapped_file and read by load_from_mapped_file.
+        /*!
+         * In these streams, the data of each int_vector starts at an aligned offset (see
+         * mapped_data_offset) and is followed by a zero word. For a stream being read, the
+         * corresponding pointer word (see std::ios_base::pword) stores the address the file is
+         * mapped to.
+         */
+        static int mapped_stream_index()
+        {
+            static const int index = std::ios_base::xalloc();
+            return index;
+        }
+
+        //! Offset at which int_vector data of the given size is stored in a mapped file,
+        //! when the data would otherwise start at the given offset.
+        /*!
+         * Data spanning at least a page starts at a page boundary, smaller data at a word boundary.
+         */
+        static uint64_t mapped_data_offset(uint64_t offset, uint64_t size_in_bytes)
+        {
+            uint64_t alignment = size_in_bytes >= 4096 ? 4096 : 8;
+            return (offset + alignment - 1) / alignment * alignment;
+        }
+
         static int open_file_for_mmap(std::string& filename, std::ios_base::openmode mode) {
 #ifdef MSVC_COMPILER
             int fd = -1;
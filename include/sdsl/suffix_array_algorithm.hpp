@@ -44,6 +44,15 @@ namespace sdsl
  * \return The size of the new interval [\ell_{new}..r_{new}].
  *         Equals zero, if no match is found.
  *
+ * \par Time complexity
+ *       \f$ \Order{ \log(r-\ell) \cdot t_{SA} + len + \log(r-\ell) } \f$ symbol comparisons in the
+ *       expected case, as each comparison skips the prefix shared with both borders
+ *       of the current search interval (mlr heuristic). The probes are shared by
+ *       the searches for both borders until the first occurrence is found.
+ * \par Reference
+ *         Udi Manber, Gene Myers:
+ *         Suffix Arrays: A New Method for On-Line String Searches.
+ *         SIAM J. Comput. 22(5): 935-948
  */
 template<class t_text_iter, class t_sa_rac, class t_pat_iter>
 typename t_sa_rac::size_type
@@ -59,24 +68,26 @@ forward_search(
     typename t_sa_rac::size_type& r_res
 )
 {
+    typedef typename t_sa_rac::size_type size_type;
     assert(l <= r); assert(r < sa_rac.size());
 
     auto size = sa_rac.size();
+    size_type m = end - begin;
 
     l_res = l;
     r_res = l - 1;
-    auto l_res_upper = r + 1;
-    auto r_res_upper = r + 1;
 
     // shortcut for too long patterns
-    if ((typename t_sa_rac::size_type)(end - begin) >= size)
+    if (m >= size)
         return 0;
 
-    // compares the pattern with CSA-prefix i (truncated to length $|pattern|$).
-    auto compare = [&](typename t_sa_rac::size_type i) -> int {
-        auto text = text_begin + sa_rac[i];
-        auto current = begin;
-        for (; current != end; current++, text++)
+    // compares the pattern with CSA-prefix i (truncated to length $|pattern|$),
+    // skipping the first `skip` symbols which are known to match.
+    // `lcp` is set to the length of the longest common prefix.
+    auto compare = [&](size_type i, size_type skip, size_type& lcp) -> int {
+        auto text = text_begin + (sa_rac[i] + skip);
+        auto current = begin + skip;
+        for (lcp = skip; current != end; ++current, ++text, ++lcp)
         {
             if (text == text_end) return 1;
             auto symbol_phrase = *current;
@@ -87,29 +98,58 @@ forward_search(
         return 0;
     };
 
-    // binary search (on min)
-    while (l_res < l_res_upper) {
-        typename t_sa_rac::size_type sample = l_res + (l_res_upper - l_res) / 2;
-        int result = compare(sample);
-        if (result == 1)
-            l_res = sample + 1;
-        else if (result == -1)
-            l_res_upper = sample;
-        else
-            l_res_upper = sample;
+    // invariant: suffixes in [l..lo-1] are smaller and suffixes in [hi..r] are greater than the pattern;
+    // lcp_lo (lcp_hi) is a lower bound for the lcp of the pattern and any suffix in [lo..hi-1]
+    size_type lo = l, hi = r + 1;
+    size_type lcp_lo = 0, lcp_hi = 0, lcp = 0;
+
+    // binary search for any occurrence (shared by both borders)
+    size_type match = hi;
+    while (lo < hi) {
+        size_type sample = lo + (hi - lo) / 2;
+        int result = compare(sample, std::min(lcp_lo, lcp_hi), lcp);
+        if (result == 1) {
+            lo = sample + 1;
+            lcp_lo = lcp;
+        } else if (result == -1) {
+            hi = sample;
+            lcp_hi = lcp;
+        } else {
+            match = sample;
+            break;
+        }
+    }
+    if (match > r) {
+        l_res = lo;
+        r_res = lo - 1;
+        return 0;
     }
 
-    // binary search (on max)
-    while (r_res + 1 < r_res_upper) {
-        typename t_sa_rac::size_type sample = r_res + (r_res_upper - r_res) / 2;
-        int result = compare(sample);
-        if (result == 1)
-            r_res = sample;
-        else if (result == -1)
-            r_res_upper = sample;
-        else
-            r_res = sample;
+    // binary search (on min) in [lo..match]; suffixes in the range are smaller than or prefixed by the pattern
+    size_type upper = match;
+    while (lo < upper) {
+        size_type sample = lo + (upper - lo) / 2;
+        if (compare(sample, lcp_lo, lcp) == 1) {
+            lo = sample + 1;
+            lcp_lo = lcp;
+        } else {
+            upper = sample;
+        }
+    }
+    l_res = lo;
+
+    // binary search (on max) in [match+1..hi-1]; suffixes in the range are prefixed by or greater than the pattern
+    size_type lower = match + 1;
+    while (lower < hi) {
+        size_type sample = lower + (hi - lower) / 2;
+        if (compare(sample, lcp_hi, lcp) == 0) {
+            lower = sample + 1;
+        } else {
+            hi = sample;
+            lcp_hi = lcp;
+        }
     }
+    r_res = lower - 1;
 
     return r_res - l_res + 1;
 }
@@ -0,0 +1,453 @@
+/* sdsl - succinct data structures library
+    Copyright (C) 2016 Simon Gog
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+/*! \file vlg_appendable_index.hpp
+    \brief vlg_appendable_index.hpp contains a variable length gap pattern index
+            over a growing text, which consists of segments indexed by vlg_index
+            and merged in the background.
+*/
+#ifndef INCLUDED_SDSL_VLG_APPENDABLE_INDEX
+#define INCLUDED_SDSL_VLG_APPENDABLE_INDEX
+
+#include "vlg_index.hpp"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//! Namespace for the succinct data structure library.
+namespace sdsl
+{
+
+//! A vlg_index supporting the appending of text.
+/*!
+ * \tparam alphabet_tag   Type of alphabet used by the indexed text and thus also the index.
+ * \tparam t_wt           Wavelet tree used for storing the suffix array.
+ *
+ * The text is the concatenation of segments, each of which is indexed by a vlg_index.
+ * Appended text forms a new segment, so appending only costs the construction of an
+ * index over the new text. Similar to a log-structured merge tree, the trailing segments
+ * are merged as soon as their total length reaches merge_ratio times the length of their
+ * predecessor, which keeps the number of segments logarithmic in the length of the text.
+ * Merges run in a background thread unless disabled in the constructor.
+ *
+ * A query is executed on each segment, while matches straddling a segment boundary are
+ * searched in the text around the boundary. The partial results are combined such that
+ * the matches are exactly the ones a vlg_index over the whole text reports.
+ * Queries operate on a snapshot of the segments, so they may run concurrently with
+ * appends and merges. Appends must not run concurrently with each other.
+ * Document boundaries (see vlg_index::set_documents) are not supported.
+ */
+template<typename alphabet_tag=byte_alphabet_tag,
+         typename t_wt=wt_int<
+             bit_vector_il<>,
+             rank_support_il<>>>
+class vlg_appendable_index
+{
+    public:
+        typedef vlg_index<alphabet_tag, t_wt>      segment_type;
+        typedef typename segment_type::size_type   size_type;
+        typedef typename segment_type::text_type   text_type;
+        typedef typename segment_type::query_type  query_type;
+        typedef std::vector<size_type>             match_type;
+
+    private:
+        struct segment_entry {
+            std::shared_ptr<const segment_type> index;
+            size_type                           offset; // text position of the first symbol
+        };
+        typedef std::vector<segment_entry> segment_list;
+
+        mutable std::mutex m_mutex;   // guards m_segments, m_merging and m_merger
+        segment_list       m_segments;
+        double             m_merge_ratio;
+        bool               m_background;
+        bool               m_merging = false;
+        std::thread        m_merger;
+
+        // Builds the index of a segment.
+        static std::shared_ptr<const segment_type> build(const text_type& text)
+        {
+            auto segment = std::make_shared<segment_type>();
+            if (alphabet_tag::WIDTH == 8) { // byte texts are stored as plain arrays
+                std::string bytes(text.begin(), text.end());
+                construct_im(*segment, bytes, 1);
+            } else {
+                construct_im(*segment, text, 0);
+            }
+            return segment;
+        }
+
+        static size_type length(const segment_entry& e)
+        {
+            return e.index->text.size();
+        }
+
+        // Returns the first of the trailing segments which should be merged (segments.size() if none).
+        size_t merge_begin(const segment_list& segments) const
+        {
+            if (segments.size() < 2)
+                return segments.size();
+            size_t k = segments.size() - 1;
+            double total = length(segments[k]);
+            while (k > 0 and total >= m_merge_ratio * length(segments[k - 1]))
+                total += length(segments[--k]);
+            return k < segments.size() - 1 ? k : segments.size();
+        }
+
+        // Replaces the trailing segments starting at segment k by a single one, as long as
+        // the merge policy demands it. The segments are built without holding the lock.
+        void merge_trailing()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            size_t k;
+            while ((k = merge_begin(m_segments)) < m_segments.size()) {
+                segment_list parts(m_segments.begin() + k, m_segments.end());
+                lock.unlock();
+                size_type len = 0;
+                for (const auto& e : parts)
+                    len += length(e);
+                text_type text(len);
+                auto out = text.begin();
+                for (const auto& e : parts)
+                    out = std::copy(e.index->text.begin(), e.index->text.end(), out);
+                segment_entry merged {build(text), parts[0].offset};
+                lock.lock();
+                // only appends happen in between, so the parts still start at segment k
+                m_segments.erase(m_segments.begin() + k, m_segments.begin() + k + parts.size());
+                m_segments.insert(m_segments.begin() + k, merged);
+            }
+            m_merging = false;
+        }
+
+        // Starts a merge if the merge policy demands it and no merge is running.
+        void schedule_merge()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_merging or merge_begin(m_segments) == m_segments.size())
+                return;
+            m_merging = true;
+            if (m_merger.joinable())
+                m_merger.join(); // has finished, as m_merging was false
+            m_merger = std::thread([this]() { merge_trailing(); });
+        }
+
+        segment_list snapshot() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_segments;
+        }
+
+        // Extracts the text [begin..end) from the segments.
+        static text_type extract(const segment_list& segments, size_type begin, size_type end)
+        {
+            text_type result(end - begin);
+            auto out = result.begin();
+            for (const auto& e : segments) {
+                size_type b = std::max(begin, e.offset), f = std::min(end, e.offset + length(e));
+                if (b < f)
+                    out = std::copy(e.index->text.begin() + (b - e.offset), e.index->text.begin() + (f - e.offset), out);
+            }
+            return result;
+        }
+
+        // Reports the matches of the query to sink, using walkers of type t_walker for the segments.
+        template<typename t_walker, typename t_sink>
+        void locate(const segment_list& segments, const query_type& query, t_sink& sink) const
+        {
+            typedef vlg_iterator<segment_type, t_walker> iterator_type;
+            size_t m = query.subpatterns.size();
+            size_type last_size = query.subpatterns.back().size();
+            size_type n = segments.empty() ? 0 : segments.back().offset + length(segments.back());
+
+            // a match straddling a boundary starts less than span positions before it
+            uint64_t span = last_size;
+            for (const auto& gap : query.gaps)
+                span = std::min(span + std::min(gap.second, (uint64_t)n), (uint64_t)n); // gaps may be unbounded
+            // the windows around the boundaries, where overlapping windows are scanned as one
+            std::vector<std::pair<size_type, size_type>> windows;
+            for (size_t s = 1; s < segments.size(); ++s) {
+                size_type b = segments[s].offset;
+                size_type window_begin = b - std::min(b, (size_type)span), window_end = std::min(n, b + span);
+                if (!windows.empty() and window_begin <= windows.back().second)
+                    windows.back().second = window_end;
+                else
+                    windows.emplace_back(window_begin, window_end);
+            }
+
+            // Each source provides the leftmost match starting at or behind a cursor: the segments
+            // provide the matches within them, the windows the matches around the boundaries.
+            // A window covering the whole text provides all matches on its own.
+            std::vector<iterator_type> iterators;
+            if (windows.size() != 1 or windows[0].first > 0 or windows[0].second < n) {
+                iterators.reserve(segments.size());
+                for (const auto& e : segments)
+                    iterators.emplace_back(*e.index, query);
+            }
+
+            struct boundary_type {
+                std::vector<std::vector<size_type>> lists;
+                std::vector<size_t> cur;
+                bool valid;
+            };
+            std::vector<boundary_type> boundaries(windows.size());
+            auto identity = [](size_type p) { return p; };
+            for (size_t w = 0; w < windows.size(); ++w) {
+                auto& boundary = boundaries[w];
+                size_type window_begin = windows[w].first;
+                auto window = extract(segments, window_begin, windows[w].second);
+                boundary.lists.resize(m);
+                for (size_t i = 0; i < m; ++i) {
+                    size_type len = query.subpatterns[i].size();
+                    for (size_type p = 0; p + len <= window.size(); ++p)
+                        if (query.matches(i, window.begin() + p))
+                            boundary.lists[i].push_back(window_begin + p);
+                }
+                boundary.cur.assign(m, 0);
+                boundary.valid = next_sorted_match(boundary.lists, query.gaps, last_size, identity, boundary.cur);
+            }
+
+            size_type cursor = 0;
+            match_type best(m), candidate(m);
+            while (true) {
+                bool found = false;
+                for (size_t s = 0; s < iterators.size(); ++s) {
+                    auto& it = iterators[s];
+                    size_type offset = segments[s].offset;
+                    if (!it.is_end() and *it + offset < cursor) {
+                        if (cursor - offset >= length(segments[s]))
+                            continue; // the segment has no further matches
+                        it.skip_to(cursor - offset);
+                    }
+                    if (it.is_end()) continue;
+                    for (size_t i = 0; i < m; ++i)
+                        candidate[i] = it[i] + offset;
+                    if (!found or candidate < best) {
+                        best.swap(candidate);
+                        found = true;
+                    }
+                }
+                for (auto& boundary : boundaries) {
+                    if (!boundary.valid) continue;
+                    if (boundary.lists[0][boundary.cur[0]] < cursor) {
+                        auto& first = boundary.lists[0];
+                        boundary.cur[0] = std::lower_bound(first.begin() + boundary.cur[0], first.end(), cursor) - first.begin();
+                        boundary.valid = next_sorted_match(boundary.lists, query.gaps, last_size, identity, boundary.cur);
+                        if (!boundary.valid) continue;
+                    }
+                    for (size_t i = 0; i < m; ++i)
+                        candidate[i] = boundary.lists[i][boundary.cur[i]];
+                    if (!found or candidate < best) {
+                        best.swap(candidate);
+                        found = true;
+                    }
+                }
+                if (!found)
+                    return;
+                report_match(sink, best.data(), best.data() + m, 0);
+                cursor = best[m - 1] + last_size;
+            }
+        }
+
+    public:
+        //! Constructor.
+        /*!
+         * \param merge_ratio  The trailing segments are merged as soon as their total length
+         *                     reaches merge_ratio times the length of their predecessor.
+         * \param background   Whether merges run in a background thread instead of within append.
+         */
+        vlg_appendable_index(double merge_ratio = 0.5, bool background = true)
+            : m_merge_ratio(merge_ratio), m_background(background) { }
+
+        //! Waits for a running merge.
+        ~vlg_appendable_index()
+        {
+            wait();
+        }
+
+        vlg_appendable_index(const vlg_appendable_index&) = delete;
+        vlg_appendable_index& operator=(const vlg_appendable_index&) = delete;
+
+        //! Length of the indexed text.
+        size_type size() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_segments.empty() ? 0 : m_segments.back().offset + length(m_segments.back());
+        }
+
+        //! Number of segments the text currently consists of.
+        size_t segments() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_segments.size();
+        }
+
+        //! Appends text to the indexed text.
+        /*!
+         * Builds an index over text and, depending on the merge policy, merges the trailing segments.
+         * \par Time complexity
+         *      The construction of a vlg_index over text, plus the merge unless it runs in the background.
+         */
+        void append(const text_type& text)
+        {
+            if (text.empty())
+                return;
+            auto segment = build(text);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                size_type offset = m_segments.empty() ? 0 : m_segments.back().offset + length(m_segments.back());
+                m_segments.push_back({segment, offset});
+            }
+            if (m_background) {
+                schedule_merge();
+            } else {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_merging = true;
+                }
+                merge_trailing();
+            }
+        }
+
+        //! Waits until no merge is running.
+        /*!
+         * The merge thread is taken over under the lock and joined outside of it, so
+         * wait may run concurrently with appends, which start new merges.
+         */
+        void wait()
+        {
+            while (true) {
+                std::thread merger;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (!m_merger.joinable())
+                        return;
+                    merger = std::move(m_merger);
+                }
+                merger.join();
+            }
+        }
+
+        //! Merges all segments into a single one.
+        void merge()
+        {
+            wait();
+            auto segments = snapshot();
+            if (segments.size() < 2)
+                return;
+            segment_entry merged {build(extract(segments, 0, size())), 0};
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_segments.erase(m_segments.begin(), m_segments.begin() + segments.size());
+            m_segments.insert(m_segments.begin(), merged);
+        }
+
+        //! Extracts the text T[begin..end].
+        /*!
+         * \pre \f$begin <= end\f$ and \f$ end < size() \f$
+         */
+        text_type extract(size_type begin, size_type end) const
+        {
+            return extract(snapshot(), begin, end + 1);
+        }
+
+        //! Reports all occurrences of the provided pattern to a sink.
+        /*!
+         * The sink is called for each match as in locate(idx, pattern, sink) of vlg_index,
+         * with the text positions referring to the whole text. Returns the sink.
+         */
+        template<typename t_sink>
+        t_sink locate(const query_type& query, t_sink sink) const
+        {
+            auto segments = snapshot();
+            if (segments.empty())
+                return sink;
+            if (!query.is_literal())
+                locate<wt_multi_range_walker<t_wt>>(segments, query, sink);
+            else
+                locate<wt_fixed_range_walker<t_wt>>(segments, query, sink);
+            return sink;
+        }
+
+        //! Retrieves all occurrences of the provided pattern.
+        std::vector<match_type> locate(const query_type& query) const
+        {
+            std::vector<match_type> result;
+            locate(query, [&](const size_type* begin, const size_type* end) {
+                result.emplace_back(begin, end);
+            });
+            return result;
+        }
+
+        //! Retrieves the number of occurrences of the provided pattern.
+        size_type count(const query_type& query) const
+        {
+            size_type result = 0;
+            locate(query, [&](size_type) { ++result; });
+            return result;
+        }
+
+        //! Serializes the data structure into the given ostream
+        size_type serialize(std::ostream& out, structure_tree_node* v=nullptr, std::string name="")const
+        {
+            auto segments = snapshot();
+            structure_tree_node* child = structure_tree::add_child(v, name, util::class_name(*this));
+            size_type written_bytes = 0;
+            written_bytes += write_member(m_merge_ratio, out, child, "merge_ratio");
+            written_bytes += write_member(segments.size(), out, child, "segments");
+            for (const auto& e : segments)
+                written_bytes += e.index->serialize(out, child, "segment");
+            structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        //! Loads the data structure from the given istream.
+        void load(std::istream& in)
+        {
+            wait();
+            segment_list segments;
+            read_member(m_merge_ratio, in);
+            size_t num_segments = 0;
+            read_member(num_segments, in);
+            size_type offset = 0;
+            for (size_t s = 0; s < num_segments; ++s) {
+                auto segment = std::make_shared<segment_type>();
+                segment->load(in);
+                segments.push_back({segment, offset});
+                offset += segment->text.size();
+            }
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_segments.swap(segments);
+        }
+};
+
+// Reports all occurrences of the provided pattern in an appendable index to a sink. Returns the sink.
+template<typename alphabet_tag, typename t_wt, typename t_sink>
+t_sink locate(const vlg_appendable_index<alphabet_tag, t_wt>& idx,
+              const typename vlg_appendable_index<alphabet_tag, t_wt>::query_type& pattern, t_sink sink) {
+    return idx.locate(pattern, std::move(sink));
+}
+
+// Retrieves the number of occurrences of the provided pattern in an appendable index.
+template<typename alphabet_tag, typename t_wt>
+typename vlg_appendable_index<alphabet_tag, t_wt>::size_type
+count(const vlg_appendable_index<alphabet_tag, t_wt>& idx,
+      const typename vlg_appendable_index<alphabet_tag, t_wt>::query_type& pattern) {
+    return idx.count(pattern);
+}
+
+} // end namespace sdsl
+#endif
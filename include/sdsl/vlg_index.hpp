@@ -26,6 +26,15 @@
 #define INCLUDED_SDSL_VLG_INDEX
 
 #include "suffix_arrays.hpp"
+#include "sd_vector.hpp"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <tuple>
 #include <vector>
 
 //! Namespace for the succinct data structure library.
@@ -37,28 +46,93 @@ namespace sdsl
  * \tparam alphabet_tag   Type of alphabet used by the query (and text to be searched within).
  *
  * This struct provides access to the individual subpatterns and gaps between them.
- * Each gap is represented by its minimum and maximum length.
+ * Each gap is represented by its minimum and maximum length. The maximum of an unbounded
+ * gap is unbounded(), which is never exceeded by the distance of two text positions.
+ * A subpattern may contain character classes, i.e., positions matching any of a set
+ * of symbols (see classes), and may tolerate a number of mismatches (see mismatches).
+ * Queries containing such subpatterns are executed with walkers traversing sets of
+ * SA intervals (see wt_multi_range_walker).
  * The struct also provides functionality for parsing regex-style query strings.
  */
 template<typename alphabet_tag>
 struct gapped_pattern_query {
     typedef int_vector<alphabet_tag::WIDTH> string_type;
+    typedef std::vector<uint64_t>           class_type; // sorted symbols of a character class
 
     std::vector<string_type> subpatterns;
     std::vector<std::pair<uint64_t,uint64_t>> gaps;
+    //! Character classes of the subpatterns: classes[i][j] contains the symbols allowed at position j
+    //! of subpattern i. Subpattern i is literal if classes[i] is empty or does not exist. For a
+    //! non-literal subpattern, subpatterns[i] contains the smallest symbol of each class.
+    std::vector<std::vector<class_type>> classes;
+    //! Maximum Hamming distance of the occurrences of each subpattern. A missing entry means 0.
+    std::vector<uint64_t> mismatches;
+
+    //! Maximum length of an unbounded gap .{min,}
+    static constexpr uint64_t unbounded()
+    {
+        return std::numeric_limits<uint64_t>::max() >> 1;
+    }
 
     //! Default constructor
     gapped_pattern_query() { }
 
     //! Constructor parsing the provided regex query
-    gapped_pattern_query(const std::string& raw_regexp)
+    /*!
+     * \param raw_regexp   Subpatterns separated by gaps of the form .{min,max}? or .{min,}?
+     *                     For byte alphabets, subpatterns may contain character classes like [Cc] or [a-z].
+     *                     A subpattern followed by {~k} matches with at most k mismatches, e.g. ACGT{~1}.
+     * \param ignore_case  Whether letters of byte alphabets match regardless of their case.
+     */
+    gapped_pattern_query(const std::string& raw_regexp, bool ignore_case = false)
     {
         bool string_patterns = alphabet_tag::WIDTH == 8;
         auto parse_subpattern = [&](std::string s) {
+            uint64_t budget = 0;
+            auto budget_pos = s.rfind("{~");
+            if (budget_pos != std::string::npos and s.back() == '}') {
+                budget = std::stoull(s.substr(budget_pos + 2, s.size() - budget_pos - 3));
+                s.erase(budget_pos);
+            }
+            mismatches.push_back(budget);
             string_type subpattern;
+            std::vector<class_type> symbol_classes;
+            bool literal = true;
             if (string_patterns) {
-                subpattern.resize(s.size());
-                std::copy(s.begin(), s.end(), subpattern.begin());
+                for (size_t k = 0; k < s.size(); ++k) {
+                    class_type symbol_class;
+                    if (s[k] == '[' and s.find(']', k + 1) != std::string::npos) {
+                        auto end = s.find(']', k + 1);
+                        for (size_t l = k + 1; l < end; ++l) {
+                            if (l + 2 < end and s[l + 1] == '-') {
+                                for (int c = (uint8_t)s[l]; c <= (uint8_t)s[l + 2]; ++c)
+                                    symbol_class.push_back(c);
+                                l += 2;
+                            } else {
+                                symbol_class.push_back((uint8_t)s[l]);
+                            }
+                        }
+                        k = end;
+                    } else {
+                        symbol_class.push_back((uint8_t)s[k]);
+                    }
+                    if (ignore_case) {
+                        size_t num_symbols = symbol_class.size();
+                        for (size_t l = 0; l < num_symbols; ++l) {
+                            symbol_class.push_back(std::tolower(symbol_class[l]));
+                            symbol_class.push_back(std::toupper(symbol_class[l]));
+                        }
+                    }
+                    std::sort(symbol_class.begin(), symbol_class.end());
+                    symbol_class.erase(std::unique(symbol_class.begin(), symbol_class.end()), symbol_class.end());
+                    if (symbol_class.empty())
+                        throw std::runtime_error("invalid subpattern: empty character class");
+                    literal = literal and symbol_class.size() == 1;
+                    symbol_classes.push_back(std::move(symbol_class));
+                }
+                subpattern.resize(symbol_classes.size());
+                for (size_t k = 0; k < symbol_classes.size(); ++k)
+                    subpattern[k] = symbol_classes[k][0];
             } else {
                 std::istringstream symbol_stream(s);
                 uint64_t symbol;
@@ -68,6 +142,7 @@ struct gapped_pattern_query {
                     subpattern[index] = symbol;
                 }
             }
+            classes.push_back(literal ? std::vector<class_type>() : std::move(symbol_classes));
             return subpattern;
         };
 
@@ -88,11 +163,14 @@ struct gapped_pattern_query {
             auto second_num_str = gap_str.substr(first_num_sep+1);
             second_num_str.pop_back();
             uint64_t first_gap_num = std::stoull(first_num_str);
-            uint64_t second_gap_num = std::stoull(second_num_str);
+            uint64_t second_gap_num = second_num_str.empty() ? unbounded() : std::stoull(second_num_str);
             if (first_gap_num > second_gap_num) {
                 throw std::runtime_error("invalid gap description: min-gap > max-gap");
             }
-            gaps.emplace_back(first_gap_num + subptr.size(),second_gap_num + subptr.size());
+            if (second_gap_num >= unbounded() - subptr.size())
+                gaps.emplace_back(first_gap_num + subptr.size(), unbounded());
+            else
+                gaps.emplace_back(first_gap_num + subptr.size(), second_gap_num + subptr.size());
             // validate lazy semantics
             if (gap_end == raw_regexp.size() or raw_regexp[gap_end] != '?') {
                 throw std::runtime_error("invalid gap description: expected '?' (lazy semantics)");
@@ -102,7 +180,214 @@ struct gapped_pattern_query {
         // extract remaining subpattern
         auto last_subpattern = raw_regexp.substr(last_gap_end+1);
         subpatterns.push_back(parse_subpattern(last_subpattern));
+        if (!has_classes())
+            classes.clear();
+        if (std::all_of(mismatches.begin(), mismatches.end(), [](uint64_t k) { return k == 0; }))
+            mismatches.clear();
     };
+
+    //! Whether the gap between subpatterns i and i+1 is unbounded.
+    bool is_unbounded(size_t i) const
+    {
+        return gaps[i].second >= unbounded();
+    }
+
+    //! Number of mismatches tolerated by subpattern i.
+    uint64_t mismatch_budget(size_t i) const
+    {
+        return i < mismatches.size() ? mismatches[i] : 0;
+    }
+
+    //! Whether subpattern i contains a character class.
+    bool has_class(size_t i) const
+    {
+        return i < classes.size() and !classes[i].empty();
+    }
+
+    //! Whether subpattern i is literal, i.e., contains no character class and tolerates no mismatch.
+    bool is_literal(size_t i) const
+    {
+        return !has_class(i) and mismatch_budget(i) == 0;
+    }
+
+    //! Whether all subpatterns are literal.
+    bool is_literal() const
+    {
+        for (size_t i = 0; i < subpatterns.size(); ++i)
+            if (!is_literal(i)) return false;
+        return true;
+    }
+
+    //! Whether any subpattern contains a character class.
+    bool has_classes() const
+    {
+        for (size_t i = 0; i < subpatterns.size(); ++i)
+            if (has_class(i)) return true;
+        return false;
+    }
+
+    //! Whether symbol matches position j of subpattern i, disregarding mismatches.
+    bool matches(size_t i, size_t j, uint64_t symbol) const
+    {
+        if (!has_class(i))
+            return subpatterns[i][j] == symbol;
+        return std::binary_search(classes[i][j].begin(), classes[i][j].end(), symbol);
+    }
+
+    //! Whether subpattern i occurs at the beginning of a string, i.e., with at most mismatch_budget(i) mismatches.
+    template<class t_iter>
+    bool matches(size_t i, t_iter begin) const
+    {
+        uint64_t budget = mismatch_budget(i);
+        for (size_t j = 0; j < subpatterns[i].size(); ++j, ++begin)
+            if (!matches(i, j, *begin) and budget-- == 0)
+                return false;
+        return true;
+    }
+};
+
+//! Boundaries of the documents of a text consisting of concatenated documents.
+/*!
+ * The start positions of the documents are stored in an sd_vector. An index storing
+ * document boundaries (see vlg_index::set_documents) only reports matches lying completely
+ * within one document. An empty object (the default) represents a single document.
+ */
+class vlg_documents
+{
+    public:
+        typedef bit_vector::size_type size_type;
+
+    private:
+        sd_vector<>                m_starts; // bit i is set iff a document starts at text position i
+        sd_vector<>::rank_1_type   m_rank;
+        sd_vector<>::select_1_type m_select;
+
+        void set_support()
+        {
+            m_rank   = sd_vector<>::rank_1_type(&m_starts);
+            m_select = sd_vector<>::select_1_type(&m_starts);
+        }
+
+    public:
+        //! Default constructor
+        vlg_documents() { set_support(); }
+
+        //! Copy constructor
+        vlg_documents(const vlg_documents& docs) : m_starts(docs.m_starts) { set_support(); }
+
+        //! Move constructor
+        vlg_documents(vlg_documents&& docs)
+        {
+            *this = std::move(docs);
+        }
+
+        //! Constructor
+        /*!
+         * \param starts Bit vector of the length of the text, marking the start position of each document.
+         * The first text position is always treated as the start of a document.
+         */
+        explicit vlg_documents(bit_vector starts)
+        {
+            if (starts.size() > 0)
+                starts[0] = 1;
+            m_starts = sd_vector<>(starts);
+            set_support();
+        }
+
+        //! Constructor
+        /*!
+         * \param text       The text.
+         * \param separator  Symbol terminating each document. It belongs to the document it terminates.
+         */
+        template<class t_text>
+        vlg_documents(const t_text& text, uint64_t separator)
+        {
+            bit_vector starts(text.size(), 0);
+            for (size_type i = 0; i + 1 < text.size(); ++i)
+                if (text[i] == separator)
+                    starts[i + 1] = 1;
+            *this = vlg_documents(std::move(starts));
+        }
+
+        //! Assignment operator
+        vlg_documents& operator=(const vlg_documents& docs)
+        {
+            if (this != &docs) {
+                m_starts = docs.m_starts;
+                set_support();
+            }
+            return *this;
+        }
+
+        //! Assignment move operator
+        vlg_documents& operator=(vlg_documents&& docs)
+        {
+            if (this != &docs) {
+                m_starts = std::move(docs.m_starts);
+                set_support();
+            }
+            return *this;
+        }
+
+        //! Swap operation
+        void swap(vlg_documents& docs)
+        {
+            if (this != &docs) {
+                m_starts.swap(docs.m_starts);
+                set_support();
+                docs.set_support();
+            }
+        }
+
+        //! Whether no document boundaries are stored.
+        bool empty() const
+        {
+            return m_starts.size() == 0;
+        }
+
+        //! Number of documents.
+        size_type size() const
+        {
+            return empty() ? 1 : m_rank(m_starts.size());
+        }
+
+        //! Returns the document containing text position pos.
+        /*!
+         * Positions behind the end of the text belong to the last document.
+         */
+        size_type document(size_type pos) const
+        {
+            return empty() ? 0 : m_rank(std::min(pos + 1, m_starts.size())) - 1;
+        }
+
+        //! Returns the start position of a document.
+        size_type document_begin(size_type doc) const
+        {
+            return empty() ? 0 : m_select(doc + 1);
+        }
+
+        //! Returns the (document, offset) pair of a text position.
+        std::pair<size_type, size_type> document_offset(size_type pos) const
+        {
+            size_type doc = document(pos);
+            return {doc, pos - document_begin(doc)};
+        }
+
+        //! Serializes the data structure into the given ostream
+        size_type serialize(std::ostream& out, structure_tree_node* v=nullptr, std::string name="")const
+        {
+            structure_tree_node* child = structure_tree::add_child(v, name, util::class_name(*this));
+            size_type written_bytes = m_starts.serialize(out, child, "starts");
+            structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        //! Loads the data structure from the given istream.
+        void load(std::istream& in)
+        {
+            m_starts.load(in);
+            set_support();
+        }
 };
 
 //! An index supporting variable length gap pattern matching.
@@ -112,6 +397,9 @@ struct gapped_pattern_query {
  *
  * This class provides the datastructures required for variable length gap pattern matching.
  * Specifically, it contains the original text as well as a wavelet tree over the suffix array.
+ * Optionally, it contains a table storing the SA interval of every k-gram (see build_kmer_table),
+ * which narrows the initial interval of the subpattern searches, and the boundaries of the
+ * documents of the text (see set_documents), which restrict matches to single documents.
  */
 template<typename alphabet_tag=byte_alphabet_tag,
          typename t_wt=wt_int<
@@ -134,19 +422,46 @@ class vlg_index
         typedef gapped_pattern_query<alphabet_tag> query_type;
 
     private:
-        text_type m_text;
-        wt_type   m_wt;
+        text_type   m_text;
+        wt_type     m_wt;
+        uint8_t     m_kmer_length = 0;  // 0 if there is no k-gram table
+        uint64_t    m_kmer_sigma  = 0;  // symbols of k-grams are in [0..m_kmer_sigma-1]
+        int_vector<> m_kmer_table;      // SA interval of k-gram g is [m_kmer_table[g]..m_kmer_table[g+1]-1]
+        vlg_documents m_documents;
+
+        // Written between the wavelet tree and the optional members to distinguish
+        // the current format from indexes which only store text and wavelet tree.
+        static constexpr uint64_t format_marker = 0x766c675f69647831ULL;
+
+        // Calculates the k-gram code of the first m_kmer_length symbols of the pattern.
+        // Returns false if the pattern contains a symbol which is not in the table or the
+        // 0-symbol, which also pads the k-grams of the last suffixes.
+        template<class t_pat_iter>
+        bool kmer_code(t_pat_iter begin, uint64_t& code) const
+        {
+            code = 0;
+            for (uint8_t j = 0; j < m_kmer_length; ++j, ++begin) {
+                uint64_t symbol = *begin;
+                if (symbol == 0 or symbol >= m_kmer_sigma)
+                    return false;
+                code = code * m_kmer_sigma + symbol;
+            }
+            return true;
+        }
 
     public:
-        const text_type& text = m_text;
-        const wt_type&   wt  = m_wt;
+        const text_type&     text = m_text;
+        const wt_type&       wt  = m_wt;
+        const vlg_documents& documents = m_documents;
 
         //! Default constructor
         vlg_index() = default;
 
         //! Copy constructor
         vlg_index(const vlg_index& idx)
-            : m_text(idx.m_text), m_wt(idx.m_wt)
+            : m_text(idx.m_text), m_wt(idx.m_wt), m_kmer_length(idx.m_kmer_length),
+              m_kmer_sigma(idx.m_kmer_sigma), m_kmer_table(idx.m_kmer_table),
+              m_documents(idx.m_documents)
         { }
 
         //! Copy constructor
@@ -164,8 +479,12 @@ class vlg_index
         vlg_index& operator=(vlg_index&& idx)
         {
             if (this != &idx) {
-                m_text     = std::move(idx.m_text);
-                m_wt       = std::move(idx.m_wt);
+                m_text        = std::move(idx.m_text);
+                m_wt          = std::move(idx.m_wt);
+                m_kmer_length = idx.m_kmer_length;
+                m_kmer_sigma  = idx.m_kmer_sigma;
+                m_kmer_table  = std::move(idx.m_kmer_table);
+                m_documents   = std::move(idx.m_documents);
             }
             return *this;
         }
@@ -176,7 +495,128 @@ class vlg_index
             if (this != &idx) {
                 m_text.swap(idx.m_text);
                 m_wt.swap(idx.m_wt);
+                std::swap(m_kmer_length, idx.m_kmer_length);
+                std::swap(m_kmer_sigma, idx.m_kmer_sigma);
+                m_kmer_table.swap(idx.m_kmer_table);
+                m_documents.swap(idx.m_documents);
+            }
+        }
+
+        //! Length of the k-grams stored in the k-gram table (0 if there is no table).
+        uint8_t kmer_length() const
+        {
+            return m_kmer_length;
+        }
+
+        //! Builds the table storing the SA interval of every k-gram.
+        /*!
+         * \param k Length of the k-grams. 0 removes the table.
+         *
+         * The table contains \f$\sigma^k+1\f$ entries, where \f$\sigma\f$ is the
+         * largest symbol of the text plus one. Hence k=2 or k=3 are reasonable
+         * choices for byte alphabets.
+         * \par Time complexity
+         *      \f$ \Order{n \cdot k + \sigma^k} \f$
+         */
+        void build_kmer_table(uint8_t k)
+        {
+            m_kmer_length = 0;
+            m_kmer_sigma  = 0;
+            m_kmer_table  = int_vector<>();
+            if (k == 0)
+                return;
+
+            uint64_t sigma = 1;
+            for (auto symbol : m_text)
+                sigma = std::max(sigma, (uint64_t)symbol + 1);
+            uint64_t entries = 1;
+            for (uint8_t j = 0; j < k; ++j) {
+                if (entries > (std::numeric_limits<uint64_t>::max() - 1) / sigma)
+                    throw std::logic_error("vlg_index: k-gram table too large");
+                entries *= sigma;
+            }
+
+            // Count the suffixes (including the empty one) by their first k symbols,
+            // where missing symbols are treated as the 0-symbol which does not occur in the text.
+            // The prefix sums then yield the SA intervals.
+            int_vector<64> table(entries + 1, 0);
+            size_type n = m_text.size();
+            uint64_t msd = entries / sigma;
+            uint64_t code = 0;
+            for (size_type j = 0; j < k; ++j)
+                code = code * sigma + (j < n ? (uint64_t)m_text[j] : 0);
+            for (size_type i = 0; i <= n; ++i) {
+                ++table[code];
+                uint64_t next = i + k < n ? (uint64_t)m_text[i + k] : 0;
+                code = (code - (i < n ? (uint64_t)m_text[i] : 0) * msd) * sigma + next;
+            }
+            uint64_t sum = 0;
+            for (uint64_t g = 0; g <= entries; ++g) {
+                uint64_t cnt = table[g];
+                table[g] = sum;
+                sum += cnt;
+            }
+
+            m_kmer_length = k;
+            m_kmer_sigma  = sigma;
+            m_kmer_table  = int_vector<>(table.size(), 0, bits::hi(sum) + 1);
+            std::copy(table.begin(), table.end(), m_kmer_table.begin());
+        }
+
+        //! Stores the document boundaries of the text.
+        /*!
+         * Afterwards, only matches lying completely within one document are reported.
+         * An empty vlg_documents object removes the boundaries.
+         */
+        void set_documents(vlg_documents docs)
+        {
+            m_documents = std::move(docs);
+        }
+
+        //! Determines the SA interval of a pattern within the SA interval [l..r].
+        /*!
+         * \param begin Iterator to the beginning of the pattern (inclusive).
+         * \param end   Iterator to the end of the pattern (exclusive).
+         * \param l     Left border of the SA interval to search in.
+         * \param r     Right border of the SA interval to search in.
+         * \return The SA interval of the pattern, which is empty if the pattern does not occur.
+         *
+         * If the k-gram table is present and the pattern is at least k symbols long,
+         * the search starts from the SA interval of the pattern's first k symbols.
+         * Patterns whose first k symbols are not covered by the table are searched
+         * without it.
+         */
+        template<class t_pat_iter>
+        range_type sa_interval(t_pat_iter begin, t_pat_iter end, size_type l, size_type r) const
+        {
+            uint64_t code;
+            if (m_kmer_length > 0 and (size_type)(end - begin) >= m_kmer_length and kmer_code(begin, code)) {
+                size_type sp = std::min(std::max(l, (size_type)m_kmer_table[code]), r + 1);
+                size_type ep = std::min(r, (size_type)m_kmer_table[code + 1] - 1);
+                if (sp > ep)
+                    return {{sp, sp - 1}};
+                if ((size_type)(end - begin) == m_kmer_length)
+                    return {{sp, ep}};
+                l = sp;
+                r = ep;
             }
+            size_type sp, ep;
+            forward_search(m_text.begin(), m_text.end(), m_wt, l, r, begin, end, sp, ep);
+            return {{sp, ep}};
+        }
+
+        //! Extracts the text T[begin..end].
+        /*!
+         * \param begin Position of the first symbol which should be extracted (inclusive).
+         * \param end   Position of the last symbol which should be extracted (inclusive).
+         * \pre \f$begin <= end\f$ and \f$ end < text.size() \f$
+         */
+        text_type extract(size_type begin, size_type end) const
+        {
+            assert(begin <= end and end < m_text.size());
+            text_type result(end - begin + 1);
+            std::copy(m_text.begin() + begin, m_text.begin() + end + 1, result.begin());
+            return result;
         }
 
         //! Serializes the data structure into the given ostream
@@ -186,27 +626,245 @@ class vlg_index
             size_type written_bytes = 0;
             written_bytes += m_text.serialize(out, child, "text");
             written_bytes += m_wt.serialize(out, child, "wt");
+            uint64_t format = format_marker;
+            written_bytes += write_member(format, out, child, "format");
+            written_bytes += write_member(m_kmer_length, out, child, "kmer_length");
+            written_bytes += write_member(m_kmer_sigma, out, child, "kmer_sigma");
+            written_bytes += m_kmer_table.serialize(out, child, "kmer_table");
+            written_bytes += m_documents.serialize(out, child, "documents");
             structure_tree::add_size(child, written_bytes);
             return written_bytes;
         }
 
         //! Loads the data structure from the given istream.
+        /*!
+         * Indexes stored without the format marker (i.e. only text and wavelet tree)
+         * are loaded without a k-gram table and with a single document.
+         */
         void load(std::istream& in)
         {
             m_text.load(in);
             m_wt.load(in);
+            m_kmer_length = 0;
+            m_kmer_sigma  = 0;
+            m_kmer_table  = int_vector<>();
+            m_documents   = vlg_documents();
+            if (in.peek() == std::char_traits<char>::eof()) {
+                in.clear(in.rdstate() & ~std::ios::eofbit);
+                return;
+            }
+            std::streampos pos = in.tellg();
+            uint64_t format = 0;
+            read_member(format, in);
+            if (format != format_marker) {
+                in.clear();
+                in.seekg(pos);
+                return;
+            }
+            read_member(m_kmer_length, in);
+            read_member(m_kmer_sigma, in);
+            m_kmer_table.load(in);
+            m_documents.load(in);
+        }
+};
+
+//! A self-index supporting variable length gap pattern matching.
+/*!
+ * \tparam alphabet_tag   Type of alphabet used by the indexed text and thus also the index.
+ * \tparam t_csa          CSA used for determining the SA intervals of the subpatterns.
+ * \tparam t_wt           Wavelet tree used for storing the suffix array.
+ *
+ * In contrast to vlg_index, this class does not store the original text.
+ * The SA intervals of the subpatterns are determined by backward search in a
+ * compressed suffix array, while the wavelet tree over the suffix array
+ * still drives the gap traversal. The CSA is used for backward search only,
+ * so its SA and ISA samples can be as sparse as possible.
+ * Text is available via extract, which accesses the ISA through the wavelet tree.
+ *
+ * For integer alphabets, t_csa has to be a CSA over an integer alphabet,
+ * e.g. csa_wt<wt_int<>, 1<<20, 1<<20, sa_order_sa_sampling<>, isa_sampling<>, int_alphabet<>>.
+ */
+template<typename alphabet_tag=byte_alphabet_tag,
+         typename t_csa=csa_wt<wt_huff<>, 1<<20, 1<<20>,
+         typename t_wt=wt_int<
+             bit_vector_il<>,
+             rank_support_il<>>>
+class vlg_self_index
+{
+        static_assert(std::is_same<typename index_tag<t_csa>::type, csa_tag>::value,
+                      "Second template argument has to be a CSA.");
+        static_assert(std::is_same<typename index_tag<t_wt>::type, wt_tag>::value,
+                      "Third template argument has to be a wavelet tree.");
+
+    public:
+        typedef alphabet_tag                  alphabet_category;
+        typedef t_csa                         csa_type;
+        typedef t_wt                          wt_type;
+        typedef typename wt_type::node_type   node_type;
+        typedef typename wt_type::size_type   size_type;
+
+        typedef int_vector<alphabet_tag::WIDTH>    text_type;
+        typedef gapped_pattern_query<alphabet_tag> query_type;
+
+    private:
+        csa_type      m_csa;
+        wt_type       m_wt;
+        vlg_documents m_documents;
+
+    public:
+        const csa_type&      csa = m_csa;
+        const wt_type&       wt  = m_wt;
+        const vlg_documents& documents = m_documents;
+
+        //! Default constructor
+        vlg_self_index() = default;
+
+        //! Copy constructor
+        vlg_self_index(const vlg_self_index& idx)
+            : m_csa(idx.m_csa), m_wt(idx.m_wt), m_documents(idx.m_documents)
+        { }
+
+        //! Move constructor
+        vlg_self_index(vlg_self_index&& idx)
+        {
+            *this = std::move(idx);
+        }
+
+        //! Constructor
+        vlg_self_index(csa_type csa, wt_type wt)
+            : m_csa(std::move(csa)), m_wt(std::move(wt))
+        { }
+
+        //! Assignment move operator
+        vlg_self_index& operator=(vlg_self_index&& idx)
+        {
+            if (this != &idx) {
+                m_csa       = std::move(idx.m_csa);
+                m_wt        = std::move(idx.m_wt);
+                m_documents = std::move(idx.m_documents);
+            }
+            return *this;
+        }
+
+        //! Swap operation
+        void swap(vlg_self_index& idx)
+        {
+            if (this != &idx) {
+                m_csa.swap(idx.m_csa);
+                m_wt.swap(idx.m_wt);
+                m_documents.swap(idx.m_documents);
+            }
+        }
+
+        //! Length of the indexed text.
+        size_type size() const
+        {
+            return m_wt.size() - 1;
+        }
+
+        //! Stores the document boundaries of the text (see vlg_index::set_documents).
+        void set_documents(vlg_documents docs)
+        {
+            m_documents = std::move(docs);
+        }
+
+        //! Determines the SA interval of a pattern within the SA interval [l..r].
+        /*!
+         * \param begin Iterator to the beginning of the pattern (inclusive).
+         * \param end   Iterator to the end of the pattern (exclusive).
+         * \param l     Left border of the SA interval to search in.
+         * \param r     Right border of the SA interval to search in.
+         * \return The SA interval of the pattern, which is empty if the pattern does not occur.
+         *
+         * The interval is determined by backward search over the whole SA and then clipped to [l..r].
+         */
+        template<class t_pat_iter>
+        range_type sa_interval(t_pat_iter begin, t_pat_iter end, size_type l, size_type r) const
+        {
+            size_type sp, ep;
+            if (backward_search(m_csa, 0, m_csa.size() - 1, begin, end, sp, ep) == 0)
+                return {{sp, sp - 1}};
+            sp = std::min(std::max(l, sp), r + 1);
+            ep = std::min(r, ep);
+            if (sp > ep)
+                return {{sp, sp - 1}};
+            return {{sp, ep}};
+        }
+
+        //! Extracts the text T[begin..end].
+        /*!
+         * \param begin Position of the first symbol which should be extracted (inclusive).
+         * \param end   Position of the last symbol which should be extracted (inclusive).
+         * \pre \f$begin <= end\f$ and \f$ end < size() \f$
+         * \par Time complexity
+         *      \f$ \Order{ t_{select} + (end-begin+1) \cdot t_{LF} } \f$
+         */
+        text_type extract(size_type begin, size_type end) const
+        {
+            assert(begin <= end and end < size());
+            text_type result(end - begin + 1);
+            // ISA[end] is the position of value end in the SA
+            size_type order = m_wt.select(1, end);
+            for (size_type i = result.size(); i > 0; --i) {
+                result[i - 1] = first_row_symbol(order, m_csa);
+                order = m_csa.lf[order];
+            }
+            return result;
+        }
+
+        //! Serializes the data structure into the given ostream
+        size_type serialize(std::ostream& out, structure_tree_node* v=nullptr, std::string name="")const
+        {
+            structure_tree_node* child = structure_tree::add_child(v, name, util::class_name(*this));
+            size_type written_bytes = 0;
+            written_bytes += m_csa.serialize(out, child, "csa");
+            written_bytes += m_wt.serialize(out, child, "wt");
+            written_bytes += m_documents.serialize(out, child, "documents");
+            structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        //! Loads the data structure from the given istream.
+        void load(std::istream& in)
+        {
+            m_csa.load(in);
+            m_wt.load(in);
+            m_documents.load(in);
         }
 };
 
+//! Policies choosing the walker vlg_iterator expands next.
+/*!
+ * The matches do not depend on the policy, only the number of expanded wavelet tree nodes does.
+ */
+enum class vlg_expansion {
+    largest_node,  //!< The walker whose current node is largest (as described in the paper).
+    rarest_anchor, //!< The walker of the subpattern with the smallest SA interval, which anchors the others.
+    gap_slack      //!< The largest node, weighted by how tightly the adjacent gaps constrain it.
+};
+
+//! Returns the name of an expansion policy.
+inline const char* expansion_name(vlg_expansion expansion)
+{
+    switch (expansion) {
+        case vlg_expansion::largest_node:  return "largest_node";
+        case vlg_expansion::rarest_anchor: return "rarest_anchor";
+        case vlg_expansion::gap_slack:     return "gap_slack";
+    }
+    return "";
+}
+
 //! An iterator implementing the variable length gap pattern search as described in the paper.
 /*!
  * \tparam type_index   Type of index to use for the search.
+ * \tparam t_walker     Type of the walkers traversing the wavelet tree for each subpattern.
  *
  * This class provides the variable length gap pattern search functionality in an on-demand fashion.
  * As long as the iterator is valid (i.e. !is_end()), 
  * it provides vector-like access to the subpattern positions of the current match.
  */
-template<typename type_index>
+template<typename type_index,
+         typename t_walker = wt_range_walker<typename type_index::wt_type>>
 class vlg_iterator : public std::iterator<std::forward_iterator_tag, typename type_index::size_type>
 {
     private:
@@ -214,21 +872,68 @@ class vlg_iterator : public std::iterator<std::forward_iterator_tag, typename ty
         typedef typename type_index::size_type size_type;
         typedef typename type_index::wt_type   wt_type;
 
-        // current state of iteration
-        std::vector<wt_range_walker<wt_type>> lex_ranges;
-        bool finished = true;
+    public:
+        //! State of the iteration.
+        /*!
+         * The state is either owned by the iterator or provided by a vlg_query_context,
+         * which allows reusing its memory across queries.
+         */
+        struct state_type {
+            // current state of iteration
+            std::vector<t_walker> lex_ranges;
+            bool finished = true;
+
+            // required query information
+            std::vector<std::pair<uint64_t,uint64_t>> gaps;
+            size_type last_subpattern_size = 0;
+            size_type unbounded_gap = 0; // gaps at least this long never prune (e.g. .{min,})
 
-        // required query information
-        const std::vector<std::pair<uint64_t,uint64_t>> gaps;
-        const size_type last_subpattern_size;
+            // matches have to start before this text position
+            size_type window_end = 0;
+
+            // document boundaries matches must not cross (nullptr if there are none)
+            const vlg_documents* documents = nullptr;
+            size_type document_width = 0; // average length of a document
+
+            // options passed to the walkers
+            typename t_walker::options_type walker_options;
+
+            // policy choosing the walker to expand next, and the per-subpattern information it uses
+            vlg_expansion expansion = vlg_expansion::largest_node;
+            std::vector<size_type> occurrences; // size of the SA interval
+            std::vector<uint64_t>  slack;       // smallest difference of maximum and minimum of the adjacent gaps
+
+            // SA intervals of a subpattern which is not literal
+            range_vec_type intervals;
+        };
+
+    private:
+        state_type  m_own;
+        state_type* m_state = &m_own;
 
         // Conservatively enforces gap constraints.
         // Returns false if the iteration has finished due to this operation.
         bool relax()
         {
+            auto& lex_ranges = m_state->lex_ranges;
+            const auto& gaps = m_state->gaps;
+            const auto* documents = m_state->documents;
             bool redo = true;
             while (redo) {
                 redo = false;
+                if (lex_ranges[0].current_node().range_begin >= m_state->window_end)
+                    return false;
+                if (documents) {
+                    // each occurrence of the last subpattern crosses a document boundary
+                    const auto& last = lex_ranges.back().current_node();
+                    if (last.range_end < last.range_begin + m_state->last_subpattern_size - 1 and
+                        documents->document(last.range_end) < documents->document(last.range_begin + m_state->last_subpattern_size - 1)) {
+                        lex_ranges.back().next_right();
+                        redo = true;
+                        if (!lex_ranges.back().has_more())
+                            return false;
+                    }
+                }
                 for (size_t i = 1; i < size(); ++i) {
                     if (lex_ranges[i - 1].current_node().range_end + gaps[i - 1].second < lex_ranges[i].current_node().range_begin) {
                         lex_ranges[i - 1].next_right();
@@ -242,52 +947,323 @@ class vlg_iterator : public std::iterator<std::forward_iterator_tag, typename ty
                         if (!lex_ranges[i].has_more())
                             return false;
                     }
+                    // all positions of subpattern i - 1 lie in documents before the ones of subpattern i
+                    // (only checked for nodes spanning less than an average document, as larger
+                    // nodes rarely qualify and the check is required for leaves only)
+                    const auto& prev = lex_ranges[i - 1].current_node();
+                    if (documents and prev.range_end - prev.range_begin < m_state->document_width and
+                        prev.range_end < lex_ranges[i].current_node().range_begin and
+                        documents->document(prev.range_end) < documents->document(lex_ranges[i].current_node().range_begin)) {
+                        lex_ranges[i - 1].next_right();
+                        redo = true;
+                        if (!lex_ranges[i - 1].has_more())
+                            return false;
+                    }
                 }
             }
             return true;
         }
 
+        // Moves the first subpattern walker to the first node lying entirely at or behind text position pos.
+        // Returns false if the iteration has finished due to this operation.
+        bool skip_first_to(size_type pos)
+        {
+            auto& first = m_state->lex_ranges[0];
+            while (first.has_more()) {
+                auto node = first.current_node();
+                if (node.range_end < pos)
+                    first.next_right();   // skip entire subtree
+                else if (node.range_begin < pos)
+                    first.next_down();    // subtree straddles pos
+                else
+                    return true;
+            }
+            return false;
+        }
+
+        // Moves a walker to its first leaf at or behind text position pos.
+        // Returns false if there is no such leaf.
+        static bool descend_to(t_walker& walker, size_type pos)
+        {
+            while (walker.has_more()) {
+                auto node = walker.current_node();
+                if (node.range_end < pos)
+                    walker.next_right();
+                else if (node.node.size > 1)
+                    walker.next_down();
+                else
+                    return true;
+            }
+            return false;
+        }
+
         // Pulls first subpattern position behind last subpattern position.
         // => enforces non-overlapping match semantics
         // Returns false if the iteration has finished due to this operation.
         bool pull_forward()
         {
-            auto last_pos = lex_ranges[lex_ranges.size() - 1].current_node().range_begin;
+            auto last_pos = m_state->lex_ranges.back().current_node().range_begin;
+            return skip_first_to(last_pos + m_state->last_subpattern_size);
+        }
 
-            // skip entire subtrees as long as save
-            while (lex_ranges[0].has_more() and
-                lex_ranges[0].current_node().range_end <= last_pos) lex_ranges[0].next_right();
-            // finds first leaf with required position
-            while (lex_ranges[0].next_leaf() and
-                lex_ranges[0].current_node().range_begin < last_pos + last_subpattern_size) ;
-            return lex_ranges[0].has_more();
+    public:
+        // Determines the SA interval of each subpattern.
+        static range_vec_type subpattern_ranges(const type_index& index,
+                                                const typename type_index::query_type& query)
+        {
+            range_vec_type ranges;
+            subpattern_ranges(index, query, ranges);
+            return ranges;
         }
 
-        // Finds the next match of the query.
-        void next()
+        // Determines the SA interval of each subpattern, reusing the memory of ranges.
+        // For a subpattern which is not literal, this is the smallest interval
+        // containing all of its SA intervals (see subpattern_intervals).
+        static void subpattern_ranges(const type_index& index,
+                                      const typename type_index::query_type& query,
+                                      range_vec_type& ranges)
         {
-            // While relaxation has not reached the end of the wavelet tree...
-            while (relax()) {
-                // ...determine the largest wavelet tree node
-                size_t r = 1;
-                size_t j = 0;
-                bool found = false;
-                for (size_t i = 0; i < size(); ++i) {
-                    auto lr = lex_ranges[i].current_node().node.size;
-                    if (lr > r) {
-                        r = lr;
-                        j = i;
-                        found = true;
-                    }
+            ranges.clear();
+            range_vec_type intervals;
+            for (size_t i = 0; i < query.subpatterns.size(); ++i) {
+                if (query.is_literal(i)) {
+                    const auto& sx = query.subpatterns[i];
+                    ranges.push_back(index.sa_interval(sx.begin(), sx.end(), 0, index.wt.size()-1));
+                } else {
+                    subpattern_intervals(index, query, i, intervals);
+                    ranges.push_back(intervals.empty() ? range_type{{1, 0}}
+                                                       : range_type{{intervals.front()[0], intervals.back()[1]}});
                 }
-
-                if (found) // if there is one, expand it
-                    lex_ranges[j].next_down();
-                else       // otherwise we found a match!
-                    return;
+                if (empty(ranges.back())) break;
             }
+        }
 
-            finished = true;
+        // Determines the SA intervals of the strings matching subpattern i in increasing order,
+        // reusing the memory of intervals. Adjacent intervals are merged.
+        static void subpattern_intervals(const type_index& index,
+                                         const typename type_index::query_type& query,
+                                         size_t i,
+                                         range_vec_type& intervals)
+        {
+            intervals.clear();
+            const auto& sx = query.subpatterns[i];
+            if (query.is_literal(i)) {
+                auto r = index.sa_interval(sx.begin(), sx.end(), 0, index.wt.size()-1);
+                if (!empty(r))
+                    intervals.push_back(r);
+                return;
+            }
+            auto prefix = sx;
+            extend_intervals(index, query, i, prefix, 0, {{0, index.wt.size()-1}}, query.mismatch_budget(i), intervals);
+        }
+
+    private:
+        // Appends the SA intervals of the strings matching subpattern i which start with prefix[0..j-1],
+        // where at most budget further mismatches are allowed.
+        static void extend_intervals(const type_index& index,
+                                     const typename type_index::query_type& query,
+                                     size_t i,
+                                     typename type_index::query_type::string_type& prefix,
+                                     size_t j,
+                                     const range_type& range,
+                                     uint64_t budget,
+                                     range_vec_type& intervals)
+        {
+            if (j == prefix.size()) {
+                if (!intervals.empty() and intervals.back()[1] + 1 == range[0])
+                    intervals.back()[1] = range[1];
+                else
+                    intervals.push_back(range);
+                return;
+            }
+            if (budget > 0) {
+                // Branch on every symbol following the prefix. The suffixes within range are sorted by
+                // their j-th symbol, so each symbol is read from the first suffix of its subinterval.
+                size_type n = index.wt.size() - 1;
+                for (size_type l = range[0]; l <= range[1];) {
+                    size_type pos = index.wt[l];
+                    if (pos + j >= n) { // suffix too short
+                        ++l;
+                        continue;
+                    }
+                    prefix[j] = index.extract(pos + j, pos + j)[0];
+                    auto r = index.sa_interval(prefix.begin(), prefix.begin() + j + 1, l, range[1]);
+                    extend_intervals(index, query, i, prefix, j + 1, r,
+                                     budget - !query.matches(i, j, prefix[j]), intervals);
+                    l = r[1] + 1;
+                }
+                return;
+            }
+            auto extend = [&](uint64_t symbol) {
+                prefix[j] = symbol;
+                auto r = index.sa_interval(prefix.begin(), prefix.begin() + j + 1, range[0], range[1]);
+                if (!empty(r))
+                    extend_intervals(index, query, i, prefix, j + 1, r, 0, intervals);
+            };
+            if (!query.has_class(i)) {
+                extend(query.subpatterns[i][j]);
+                return;
+            }
+            for (auto symbol : query.classes[i][j]) // in increasing order, so the intervals are sorted
+                extend(symbol);
+        }
+
+        // Adds a walker traversing a set of SA intervals.
+        static void add_walker(std::vector<t_walker>& walkers, const wt_type& wt, const range_vec_type& intervals,
+                               const wt_node_cache<wt_type>& root_node,
+                               const typename t_walker::options_type& options, std::true_type)
+        {
+            walkers.emplace_back(wt, intervals, root_node, options);
+        }
+
+        static void add_walker(std::vector<t_walker>& walkers, const wt_type& wt, const range_vec_type& intervals,
+                               const wt_node_cache<wt_type>& root_node,
+                               const typename t_walker::options_type& options, std::false_type)
+        {
+            if (intervals.size() != 1)
+                throw std::invalid_argument("vlg_iterator: non-literal subpatterns require a walker supporting "
+                                            "sets of ranges (e.g. wt_multi_range_walker)");
+            walkers.emplace_back(wt, intervals[0], root_node, options);
+        }
+
+    private:
+
+        // Whether subpattern i follows an unbounded gap.
+        bool unbounded(size_t i) const
+        {
+            return i > 0 and m_state->gaps[i - 1].second >= m_state->unbounded_gap;
+        }
+
+        // Whether the current node of walker i may be expanded. A subpattern following an unbounded
+        // gap is only bounded by the position of its predecessor, so it is not expanded before that
+        // position is known.
+        bool expandable(size_t i) const
+        {
+            const auto& lex_ranges = m_state->lex_ranges;
+            return lex_ranges[i].current_node().node.size > 1 and
+                   !(unbounded(i) and lex_ranges[i - 1].current_node().node.size > 1);
+        }
+
+        // Chooses the walker to expand next according to the expansion policy.
+        // Returns false if all walkers point to leaves, i.e., the current nodes form a match.
+        bool choose_expansion(size_t& j) const
+        {
+            const auto& lex_ranges = m_state->lex_ranges;
+            bool found = false;
+            switch (m_state->expansion) {
+                case vlg_expansion::largest_node: {
+                    size_type r = 1;
+                    for (size_t i = 0; i < size(); ++i) {
+                        auto lr = lex_ranges[i].current_node().node.size;
+                        if (lr > r and expandable(i)) {
+                            r = lr;
+                            j = i;
+                            found = true;
+                        }
+                    }
+                    break;
+                }
+                case vlg_expansion::rarest_anchor: {
+                    // the subpattern with the fewest occurrences is expanded first; ties by node size
+                    const auto& occ = m_state->occurrences;
+                    for (size_t i = 0; i < size(); ++i) {
+                        if (expandable(i) and (!found or occ[i] < occ[j] or (occ[i] == occ[j] and
+                                               lex_ranges[i].current_node().node.size > lex_ranges[j].current_node().node.size))) {
+                            j = i;
+                            found = true;
+                        }
+                    }
+                    break;
+                }
+                case vlg_expansion::gap_slack: {
+                    // Expanding a node lets relax prune its children if the text range of the node is large
+                    // compared to the slack of its gaps. Hence the node size is weighted by span/(span+slack).
+                    double r = 0;
+                    for (size_t i = 0; i < size(); ++i) {
+                        if (!expandable(i)) continue;
+                        const auto& node = lex_ranges[i].current_node();
+                        double span = node.range_end - node.range_begin + 1;
+                        double score = node.node.size * span / (span + m_state->slack[i]);
+                        if (score > r) {
+                            r = score;
+                            j = i;
+                            found = true;
+                        }
+                    }
+                    break;
+                }
+            }
+            return found;
+        }
+
+        // Finds the next match of the query.
+        void next()
+        {
+            auto& lex_ranges = m_state->lex_ranges;
+            const auto& gaps = m_state->gaps;
+            // While relaxation has not reached the end of the wavelet tree...
+            while (relax()) {
+                // ...determine the node to expand
+                size_t j = 0;
+                if (!choose_expansion(j)) // if there is none, we found a match!
+                    return;
+                if (unbounded(j)) { // find the next occurrence by a single descent
+                    if (!descend_to(lex_ranges[j], lex_ranges[j - 1].current_node().range_begin + gaps[j - 1].first))
+                        break;
+                } else {      // expand the chosen node
+                    lex_ranges[j].next_down();
+                }
+            }
+
+            m_state->finished = true;
+        }
+
+        // Initializes the state and finds the first match.
+        void init(const type_index& index,
+                  const typename type_index::query_type& query,
+                  const range_vec_type& ranges,
+                  size_type window_begin,
+                  size_type window_end)
+        {
+            auto& lex_ranges = m_state->lex_ranges;
+            lex_ranges.clear();
+            m_state->finished = true;
+            m_state->gaps.assign(query.gaps.begin(), query.gaps.end());
+            m_state->last_subpattern_size = query.subpatterns[query.subpatterns.size() - 1].size();
+            m_state->unbounded_gap = index.wt.size();
+            m_state->occurrences.clear();
+            m_state->slack.assign(ranges.size(), index.wt.size());
+            for (size_t i = 0; i < ranges.size(); ++i) {
+                m_state->occurrences.push_back(empty(ranges[i]) ? 0 : ranges[i][1] - ranges[i][0] + 1);
+                for (size_t k = i; k <= i + 1; ++k) { // gaps k-1 and k are adjacent to subpattern i
+                    if (k > 0 and k < ranges.size())
+                        m_state->slack[i] = std::min(m_state->slack[i], (size_type)(query.gaps[k - 1].second - query.gaps[k - 1].first));
+                }
+            }
+            m_state->window_end = window_end;
+            m_state->documents = index.documents.empty() ? nullptr : &index.documents;
+            m_state->document_width = index.wt.size() / index.documents.size() + 1;
+
+            // initialize wavelet tree iterators using the SA range of each subpattern
+            auto root_node = wt_node_cache<wt_type>(index.wt.root(), index.wt);
+            lex_ranges.reserve(ranges.size());
+            for (size_t i = 0; i < ranges.size(); ++i) {
+                // shortcut on empty range
+                if (empty(ranges[i])) return;
+                if (query.is_literal(i)) {
+                    lex_ranges.emplace_back(index.wt, ranges[i], root_node, m_state->walker_options);
+                } else {
+                    subpattern_intervals(index, query, i, m_state->intervals);
+                    add_walker(lex_ranges, index.wt, m_state->intervals, root_node, m_state->walker_options,
+                               std::is_constructible<t_walker, const wt_type&, const range_vec_type&,
+                               wt_node_cache<wt_type>, const typename t_walker::options_type&>());
+                }
+            }
+
+            // skip to the start of the window and find first match
+            if (!skip_first_to(window_begin)) return;
+            m_state->finished = false;
+            next();
         }
 
     public:
@@ -295,48 +1271,87 @@ class vlg_iterator : public std::iterator<std::forward_iterator_tag, typename ty
         typedef typename type_index::size_type position_type;
 
         //! Default constructor.
-        vlg_iterator()
-            : gaps()
-            , last_subpattern_size(0) { }
+        vlg_iterator() { }
+
+        //! Copy constructor. Copies of an iterator using external state share that state.
+        vlg_iterator(const vlg_iterator& it)
+            : m_own(it.m_own)
+            , m_state(it.m_state == &it.m_own ? &m_own : it.m_state) { }
+
+        //! Move constructor.
+        vlg_iterator(vlg_iterator&& it)
+            : m_own(std::move(it.m_own))
+            , m_state(it.m_state == &it.m_own ? &m_own : it.m_state) { }
+
+        // The walkers refer to the wavelet tree, so they can not be reassigned.
+        vlg_iterator& operator=(const vlg_iterator&) = delete;
+        vlg_iterator& operator=(vlg_iterator&&) = delete;
 
         //! Constructor.
         vlg_iterator(const type_index& index,
                      const typename type_index::query_type& query)
-            : gaps(query.gaps)
-            , last_subpattern_size(query.subpatterns[query.subpatterns.size() - 1].size())
-        {
-            // initialize wavelet tree iterators using the SA range of each subpattern
-            auto root_node = wt_node_cache<wt_type>(index.wt.root(), index.wt);
-            for (auto sx : query.subpatterns) {
-                size_type sp, ep;
-                forward_search(index.text.begin(), index.text.end(), index.wt, 0, index.wt.size()-1, sx.begin(), sx.end(), sp, ep);
-                lex_ranges.emplace_back(index.wt, range_type({sp, ep}), root_node);
+            : vlg_iterator(index, query, subpattern_ranges(index, query)) { }
 
-                // shortcut on empty range
-                if (sp > ep) return;
-            }
+        //! Constructor restricting the search to matches starting in a window of the text.
+        /*!
+         * \param window_begin First text position a match may start at (inclusive).
+         * \param window_end   Text position all matches have to start before (exclusive).
+         *
+         * Matches are reported exactly as the unrestricted iterator would report them
+         * after skipping to a match starting at or behind window_begin.
+         */
+        vlg_iterator(const type_index& index,
+                     const typename type_index::query_type& query,
+                     size_type window_begin,
+                     size_type window_end)
+            : vlg_iterator(index, query, subpattern_ranges(index, query), window_begin, window_end) { }
 
-            // find first match
-            finished = false;
-            next();
+        //! Constructor using precomputed SA intervals of the subpatterns.
+        vlg_iterator(const type_index& index,
+                     const typename type_index::query_type& query,
+                     const range_vec_type& ranges)
+            : vlg_iterator(index, query, ranges, 0, index.wt.size()) { }
+
+        //! Constructor using precomputed SA intervals of the subpatterns and restricting the search to a window.
+        vlg_iterator(const type_index& index,
+                     const typename type_index::query_type& query,
+                     const range_vec_type& ranges,
+                     size_type window_begin,
+                     size_type window_end)
+        {
+            init(index, query, ranges, window_begin, window_end);
+        }
+
+        //! Constructor using precomputed SA intervals of the subpatterns and external state.
+        /*!
+         * The iterator (and all copies of it) uses the memory of state instead of its own,
+         * so it is only valid as long as state is not used for another query.
+         */
+        vlg_iterator(const type_index& index,
+                     const typename type_index::query_type& query,
+                     const range_vec_type& ranges,
+                     state_type& state)
+            : m_state(&state)
+        {
+            init(index, query, ranges, 0, index.wt.size());
         }
 
         //! Returns whether this iterator has ended, i.e. does not point to a match anymore.
         bool is_end() const
         {
-            return finished;
+            return m_state->finished;
         }
 
         //! Returns the number of subpattern positions this iterator points to.
         size_t size() const
         {
-            return lex_ranges.size();
+            return m_state->lex_ranges.size();
         }
 
         //! Returns a subpatterns text position of the current match.
         position_type operator[](int subpattern_index) const
         {
-            return lex_ranges[subpattern_index].current_node().range_begin;
+            return m_state->lex_ranges[subpattern_index].current_node().range_begin;
         }
 
         //! Returns the starting position of the current match (which is the first subpattern's position).
@@ -351,7 +1366,25 @@ class vlg_iterator : public std::iterator<std::forward_iterator_tag, typename ty
             if (pull_forward())
                 next();
             else
-                finished = true;
+                m_state->finished = true;
+            return *this;
+        }
+
+        //! Advances the iterator to the first match starting at or behind text position pos.
+        /*!
+         * \pre pos lies behind the starting position of the current match.
+         *
+         * The matches reported afterwards are the ones of an iterator whose search starts
+         * at pos (see the constructor restricting the search to a window). If pos is the
+         * start of a document of an index with document boundaries, these are exactly
+         * the matches of the remaining documents.
+         */
+        vlg_iterator& skip_to(size_type pos)
+        {
+            if (skip_first_to(pos))
+                next();
+            else
+                m_state->finished = true;
             return *this;
         }
 
@@ -372,43 +1405,1141 @@ class vlg_iterator : public std::iterator<std::forward_iterator_tag, typename ty
         }
 };
 
+//! Memory for executing queries, which is reused across queries.
+/*!
+ * \tparam type_index   Type of index the queries are executed on.
+ * \tparam t_walker     Type of walker traversing the wavelet tree for each subpattern.
+ *
+ * A context holds the preprocessed query (its gaps and the SA intervals of its subpatterns)
+ * and the walkers, whose traversal stacks are stored in place. The memory is retained between
+ * queries, so as soon as a context has processed a query with the maximal number of
+ * subpatterns, executing further queries does not allocate heap memory (unless the walkers
+ * do so, like wt_hybrid_range_walker and wt_multi_range_walker).
+ * A context is meant to be owned by one worker thread and must not be used concurrently.
+ */
+template<typename type_index,
+         typename t_walker = wt_fixed_range_walker<typename type_index::wt_type>>
+class vlg_query_context
+{
+    public:
+        typedef t_walker                                walker_type;
+        typedef vlg_iterator<type_index, walker_type>   iterator_type;
+        typedef typename walker_type::options_type      options_type;
+
+    private:
+        typename iterator_type::state_type m_state;
+        range_vec_type                     m_ranges;
+
+    public:
+        //! Constructor.
+        /*!
+         * \param options   Options of the walkers, e.g., the cutoff of wt_hybrid_range_walker.
+         * \param expansion Policy choosing the walker to expand next.
+         */
+        vlg_query_context(const options_type& options = options_type(),
+                          vlg_expansion expansion = vlg_expansion::largest_node)
+        {
+            m_state.walker_options = options;
+            m_state.expansion = expansion;
+        }
+
+        //! Sets the policy choosing the walker to expand next for subsequent queries.
+        void set_expansion(vlg_expansion expansion)
+        {
+            m_state.expansion = expansion;
+        }
+
+        //! Prepares the query and returns an iterator pointing to its first match.
+        /*!
+         * The iterator and all copies of it share the memory of the context,
+         * so they are only valid until the context is used for the next query.
+         */
+        iterator_type begin(const type_index& idx, const typename type_index::query_type& query)
+        {
+            iterator_type::subpattern_ranges(idx, query, m_ranges);
+            return iterator_type(idx, query, m_ranges, m_state);
+        }
+};
+
+//! Advances the cursors into sorted lists of subpattern positions to the next match.
+/*!
+ * \param cur    For each subpattern, the index of the current list entry.
+ *
+ * Entries are only skipped if they can not be part of a match with the current entries
+ * of the other lists, so the cursors end up at the leftmost match whose first position
+ * is at or behind the current entry of the first list. Returns false if there is no such
+ * match. The remaining parameters are the ones of match_sorted_positions.
+ */
+template<typename t_list, typename t_gaps, typename t_pos>
+bool next_sorted_match(const std::vector<t_list>& lists, const t_gaps& gaps, uint64_t last_subpattern_size,
+                       t_pos pos, std::vector<size_t>& cur, const vlg_documents* documents = nullptr)
+{
+    size_t m = lists.size();
+    for (size_t i = 0; i < m; ++i)
+        if (cur[i] >= lists[i].size()) return false;
+    auto at = [&](size_t i) -> uint64_t { return pos(lists[i][cur[i]]); };
+    // move each position forward until the gap constraints are fulfilled
+    bool redo = true;
+    while (redo) {
+        redo = false;
+        if (documents and documents->document(at(m-1)) < documents->document(at(m-1) + last_subpattern_size - 1)) {
+            redo = true;
+            if (++cur[m-1] == lists[m-1].size()) return false;
+        }
+        for (size_t i = 1; i < m; ++i) {
+            if (documents and documents->document(at(i-1)) < documents->document(at(i))) {
+                redo = true;
+                if (++cur[i-1] == lists[i-1].size()) return false;
+            }
+            if (at(i-1) + gaps[i-1].second < at(i)) {
+                redo = true;
+                if (++cur[i-1] == lists[i-1].size()) return false;
+            }
+            if (at(i-1) + gaps[i-1].first > at(i)) {
+                redo = true;
+                if (++cur[i] == lists[i].size()) return false;
+            }
+        }
+    }
+    return true;
+}
+
+//! Reports the matches among sorted lists of subpattern positions.
+/*!
+ * \param lists                  For each subpattern, a non-empty list of entries sorted by position.
+ * \param gaps                   Gaps between the subpatterns (see gapped_pattern_query).
+ * \param last_subpattern_size   Length of the last subpattern.
+ * \param pos                    Function mapping a list entry to its text position.
+ * \param result                 Vector the matches are appended to.
+ * \param documents              Document boundaries matches must not cross (nullptr if there are none).
+ *
+ * The matches are the ones reported by vlg_iterator, i.e., for each match the
+ * leftmost valid positions are chosen and the next match starts behind the current one.
+ */
+template<typename t_list, typename t_gaps, typename t_pos, typename t_match>
+void match_sorted_positions(const std::vector<t_list>& lists, const t_gaps& gaps, uint64_t last_subpattern_size,
+                            t_pos pos, std::vector<t_match>& result, const vlg_documents* documents = nullptr)
+{
+    size_t m = lists.size();
+    std::vector<size_t> cur(m, 0);
+    auto at = [&](size_t i) -> uint64_t { return pos(lists[i][cur[i]]); };
+    while (next_sorted_match(lists, gaps, last_subpattern_size, pos, cur, documents)) {
+        t_match match(m);
+        for (size_t i = 0; i < m; ++i)
+            match[i] = at(i);
+        result.push_back(std::move(match));
+        // the next match starts behind the current one
+        uint64_t next_begin = at(m-1) + last_subpattern_size;
+        while (at(0) < next_begin)
+            if (++cur[0] == lists[0].size()) return;
+    }
+}
+
+//! Estimated number of occurrences of a pattern (see vlg_level_engine::estimate_count).
+struct vlg_count_estimate {
+    double   estimate = 0;  //!< Estimated number of occurrences.
+    uint64_t lower = 0;     //!< The number of occurrences is at least lower...
+    uint64_t upper = 0;     //!< ...and at most upper.
+    bool     exact = true;  //!< Whether the number of occurrences was determined exactly.
+    size_t   nodes = 0;     //!< Number of wavelet tree nodes expanded.
+};
+
+//! Level-synchronous variable length gap pattern matching.
+/*!
+ * \tparam type_index   Type of index the queries are executed on.
+ *
+ * Instead of expanding one wavelet tree node at a time (see vlg_iterator), the engine keeps a
+ * frontier of (node, SA range) pairs for each subpattern and expands the frontiers of all
+ * subpatterns level by level. Before each level, nodes which can not be part of a match
+ * are pruned using the gap constraints. The rank probes of a level are issued in the
+ * order of the node offsets. For a wavelet matrix (wm_int), all nodes of a level lie in the
+ * same bit vector, so a level is processed in a single sweep over its bits and rank directory.
+ * On the leaf level, the frontiers contain the sorted subpattern positions, which are matched
+ * with the same (non-overlapping, lazy) semantics as vlg_iterator.
+ *
+ * As the frontiers are materialized, the memory usage is linear in the number of nodes
+ * of the widest level. The memory is retained between queries.
+ */
+template<typename type_index>
+class vlg_level_engine
+{
+    public:
+        typedef typename type_index::size_type  size_type;
+        typedef typename type_index::query_type query_type;
+        typedef std::vector<size_type>          match_type;
+
+    private:
+        typedef typename type_index::node_type node_type;
+
+        struct frontier_entry {
+            node_type  node;
+            range_type range;
+            size_type  range_begin; // value range of node, i.e., text positions
+            size_type  range_end;
+        };
+        typedef std::vector<frontier_entry> frontier_type;
+
+        // number of children of an inner node
+        static const size_t arity = wt_arity<typename type_index::wt_type>::value;
+
+        // (position of the first rank probe, subpattern, index in frontier)
+        typedef std::tuple<size_type, size_t, size_t> probe_type;
+
+        const type_index&                        m_idx;
+        std::vector<std::pair<uint64_t,uint64_t>> m_gaps;
+        std::vector<frontier_type>               m_frontiers;
+        std::vector<frontier_type>               m_children;
+        std::vector<probe_type>                  m_probes;
+        range_vec_type                           m_ranges;
+        range_vec_type                           m_intervals;
+        std::vector<double>                      m_occurrences;  // number of occurrences of each subpattern
+        bool                                     m_multi = false; // whether a frontier contains a node several times
+        size_t                                   m_expanded = 0; // number of nodes expanded by descend
+
+        const vlg_documents* documents() const
+        {
+            return m_idx.documents.empty() ? nullptr : &m_idx.documents;
+        }
+
+        frontier_entry make_entry(const node_type& v, const range_type& r) const
+        {
+            auto value_range = m_idx.wt.value_range(v);
+            return {v, r, value_range[0], value_range[1]};
+        }
+
+        // Removes the entries of frontier b which have no partner in frontier a, such that
+        // a position in a and a position in b are at least min_gap and at most max_gap apart.
+        // If backward is set, b precedes a in the query.
+        static void prune(const frontier_type& a, frontier_type& b, uint64_t min_gap, uint64_t max_gap, bool backward)
+        {
+            size_t j = 0, kept = 0;
+            for (size_t k = 0; k < b.size(); ++k) {
+                const auto& v = b[k];
+                bool keep;
+                if (!backward) { // a precedes b
+                    while (j < a.size() and a[j].range_end + max_gap < v.range_begin) ++j;
+                    keep = j < a.size() and a[j].range_begin + min_gap <= v.range_end;
+                } else {         // b precedes a
+                    while (j < a.size() and a[j].range_end < v.range_begin + min_gap) ++j;
+                    keep = j < a.size() and a[j].range_begin <= v.range_end + max_gap;
+                }
+                if (keep)
+                    b[kept++] = v;
+            }
+            b.resize(kept);
+        }
+
+        // Conservatively enforces the gap constraints between neighboring frontiers.
+        // Returns false if a frontier became empty.
+        bool prune()
+        {
+            for (size_t i = 1; i < m_frontiers.size(); ++i) {
+                prune(m_frontiers[i-1], m_frontiers[i], m_gaps[i-1].first, m_gaps[i-1].second, false);
+                if (m_frontiers[i].empty()) return false;
+            }
+            for (size_t i = m_frontiers.size() - 1; i > 0; --i) {
+                prune(m_frontiers[i], m_frontiers[i-1], m_gaps[i-1].first, m_gaps[i-1].second, true);
+                if (m_frontiers[i-1].empty()) return false;
+            }
+            return true;
+        }
+
+        // Expands all frontier entries by one level, issuing the rank probes in order of their offsets.
+        void expand()
+        {
+            m_probes.clear();
+            for (size_t i = 0; i < m_frontiers.size(); ++i) {
+                m_children[i].resize(arity * m_frontiers[i].size());
+                for (size_t k = 0; k < m_frontiers[i].size(); ++k) {
+                    const auto& e = m_frontiers[i][k];
+                    m_probes.emplace_back(e.node.offset + e.range[0], i, k);
+                }
+            }
+            std::sort(m_probes.begin(), m_probes.end());
+            for (const auto& probe : m_probes) {
+                size_t i = std::get<1>(probe), k = std::get<2>(probe);
+                const auto& e = m_frontiers[i][k];
+                auto children = m_idx.wt.expand_with_range(e.node, e.range);
+                for (size_t c = 0; c < arity; ++c)
+                    m_children[i][arity*k + c] = make_entry(children[c].first, children[c].second);
+            }
+            // keep children with a non-empty range in the order of their value ranges
+            for (size_t i = 0; i < m_frontiers.size(); ++i) {
+                auto& children = m_children[i];
+                children.erase(std::remove_if(children.begin(), children.end(), [](const frontier_entry& e) {
+                    return empty(e.range);
+                }), children.end());
+                if (m_multi) { // the children of the entries of the same node interleave
+                    std::stable_sort(children.begin(), children.end(), [](const frontier_entry& a, const frontier_entry& b) {
+                        return a.range_begin < b.range_begin;
+                    });
+                }
+                m_frontiers[i].swap(children);
+            }
+        }
+
+        // Expands and prunes the frontiers until they reach the leaves or expanding
+        // the next level would exceed the node budget. Returns false if there is no match.
+        bool descend(const query_type& query, size_t budget)
+        {
+            m_expanded = 0;
+            vlg_iterator<type_index>::subpattern_ranges(m_idx, query, m_ranges);
+            if (m_ranges.size() < query.subpatterns.size() or empty(m_ranges.back()))
+                return false;
+            size_t m = m_ranges.size();
+            m_gaps.assign(query.gaps.begin(), query.gaps.end());
+            m_frontiers.resize(m);
+            m_children.resize(m);
+            auto root = m_idx.wt.root();
+            m_multi = false;
+            m_occurrences.resize(m);
+            for (size_t i = 0; i < m; ++i) {
+                // a non-literal subpattern starts with an entry per SA interval
+                vlg_iterator<type_index>::subpattern_intervals(m_idx, query, i, m_intervals);
+                m_frontiers[i].clear();
+                m_occurrences[i] = 0;
+                for (const auto& r : m_intervals) {
+                    m_frontiers[i].push_back(make_entry(root, r));
+                    m_occurrences[i] += r[1] - r[0] + 1;
+                }
+                m_multi = m_multi or m_intervals.size() > 1;
+            }
+            while (!m_idx.wt.is_leaf(m_frontiers[0][0].node)) {
+                if (!prune())
+                    return false;
+                size_t nodes = 0;
+                for (const auto& frontier : m_frontiers)
+                    nodes += frontier.size();
+                if (nodes > budget - m_expanded)
+                    return true;
+                m_expanded += nodes;
+                expand();
+            }
+            return prune();
+        }
+
+    public:
+        //! Constructor.
+        vlg_level_engine(const type_index& idx) : m_idx(idx) { }
+
+        //! Retrieves all occurrences of the provided pattern.
+        /*!
+         * Each match is represented by the text positions of its subpatterns.
+         * The result equals the matches reported by vlg_iterator.
+         */
+        std::vector<match_type> locate(const query_type& query)
+        {
+            std::vector<match_type> result;
+            if (!descend(query, std::numeric_limits<size_t>::max()))
+                return result;
+            match_sorted_positions(m_frontiers, m_gaps, query.subpatterns.back().size(),
+            [](const frontier_entry& e) { return e.range_begin; }, result, documents());
+            return result;
+        }
+
+        //! Estimates the number of occurrences of the provided pattern.
+        /*!
+         * \param query    The pattern.
+         * \param budget   Maximum number of wavelet tree nodes to expand.
+         *
+         * The frontiers are expanded and pruned as in locate, until the next level would exceed
+         * the node budget. If the leaf level is reached, the occurrences are counted exactly.
+         * Otherwise, the positions within each remaining node are assumed to be uniformly
+         * distributed and the estimate is extrapolated from the expected number of positions
+         * each subpattern finds within its gap window. The bounds hold deterministically:
+         * The upper bound counts the surviving positions of the first subpattern, while the
+         * lower bound only counts positions of the first subpattern whose nodes are guaranteed
+         * to start a match. If the index stores document boundaries, the lower bound is 0
+         * unless the count is exact.
+         */
+        vlg_count_estimate estimate_count(const query_type& query, size_t budget)
+        {
+            vlg_count_estimate result;
+            bool exhausted = !descend(query, budget);
+            result.nodes = m_expanded;
+            if (exhausted)
+                return result;
+            size_t m = m_frontiers.size();
+            size_type last_size = query.subpatterns.back().size();
+            if (m_idx.wt.is_leaf(m_frontiers[0][0].node)) {
+                std::vector<std::vector<size_type>> matches;
+                match_sorted_positions(m_frontiers, m_gaps, last_size,
+                [](const frontier_entry& e) { return e.range_begin; }, matches, documents());
+                result.lower = result.upper = matches.size();
+                result.estimate = matches.size();
+                return result;
+            }
+            result.exact = false;
+
+            // a match covers at least min_span and at most max_span text positions
+            size_type n = m_idx.wt.size();
+            uint64_t min_span = last_size, max_span = last_size;
+            for (const auto& gap : m_gaps) {
+                min_span += gap.first;
+                max_span = std::min(max_span + gap.second, (uint64_t)n); // gaps may be unbounded
+            }
+            auto node_end = [&](const frontier_entry& e) { return std::min(e.range_end, n - 1); };
+            auto node_size = [](const frontier_entry& e) { return (double)(e.range[1] - e.range[0] + 1); };
+
+            // upper bound: surviving positions of the first subpattern, matches do not overlap
+            uint64_t upper = 0;
+            for (const auto& e : m_frontiers[0])
+                upper += e.range[1] - e.range[0] + 1;
+            result.upper = std::min(upper, (uint64_t)((n - 1) / std::max(min_span, (uint64_t)1) + 1));
+
+            // lower bound: a node is guaranteed if each of its positions starts a match, which holds if
+            // a guaranteed node of the next subpattern lies completely within the gap window of each position
+            std::vector<bool> guaranteed(m_frontiers[m-1].size(), true);
+            std::vector<size_t> first_guaranteed; // first guaranteed node at or behind index j
+            for (size_t i = m - 1; i > 0; --i) {
+                const auto& next = m_frontiers[i];
+                const auto& cur = m_frontiers[i-1];
+                first_guaranteed.assign(next.size() + 1, next.size());
+                for (size_t j = next.size(); j > 0; --j)
+                    first_guaranteed[j-1] = guaranteed[j-1] ? j-1 : first_guaranteed[j];
+                guaranteed.assign(cur.size(), false);
+                for (size_t k = 0; k < cur.size(); ++k) {
+                    const auto& a = cur[k];
+                    uint64_t window_begin = node_end(a) + m_gaps[i-1].first;
+                    size_t j = std::lower_bound(next.begin(), next.end(), window_begin,
+                    [](const frontier_entry& e, uint64_t x) { return e.range_begin < x; }) - next.begin();
+                    j = first_guaranteed[j];
+                    guaranteed[k] = j < next.size() and node_end(next[j]) <= a.range_begin + m_gaps[i-1].second;
+                }
+            }
+            uint64_t sure = 0;
+            for (size_t k = 0; k < m_frontiers[0].size(); ++k)
+                if (guaranteed[k]) sure += m_frontiers[0][k].range[1] - m_frontiers[0][k].range[0] + 1;
+            result.lower = documents() ? 0 : (sure + max_span - 1) / max_span; // no guarantee across documents
+
+            // estimate: probability that a position of subpattern i continues to a match, per node
+            std::vector<double> survival(m_frontiers[m-1].size(), 1.0), next_survival;
+            std::vector<double> mass; // mass[k] = expected continuing positions in nodes [0..k-1]
+            for (size_t i = m - 1; i > 0; --i) {
+                const auto& next = m_frontiers[i];
+                mass.assign(1, 0.0);
+                for (size_t k = 0; k < next.size(); ++k)
+                    mass.push_back(mass.back() + node_size(next[k]) * survival[k]);
+                // expected continuing positions of subpattern i in [0..x-1]
+                auto mass_before = [&](double x) {
+                    size_t k = std::upper_bound(next.begin(), next.end(), x, [](double y, const frontier_entry& e) {
+                        return y < e.range_begin;
+                    }) - next.begin();
+                    if (k == 0) return 0.0;
+                    const auto& e = next[k-1];
+                    double len = node_end(e) - e.range_begin + 1;
+                    double frac = std::min(1.0, (x - e.range_begin) / len);
+                    return mass[k-1] + (mass[k] - mass[k-1]) * frac;
+                };
+                const auto& cur = m_frontiers[i-1];
+                next_survival.resize(cur.size());
+                for (size_t k = 0; k < cur.size(); ++k) {
+                    double mid = (cur[k].range_begin + node_end(cur[k])) / 2.0;
+                    double expected = mass_before(mid + m_gaps[i-1].second + 1) - mass_before(mid + m_gaps[i-1].first);
+                    next_survival[k] = 1.0 - std::exp(-expected);
+                }
+                survival.swap(next_survival);
+            }
+            double estimate = 0;
+            for (size_t k = 0; k < m_frontiers[0].size(); ++k)
+                estimate += node_size(m_frontiers[0][k]) * survival[k];
+            // Matches do not overlap: the positions starting a match are lost if they lie within
+            // the previous match, whose length is estimated from the expected distance to the
+            // next occurrence of each subpattern.
+            double match_length = last_size;
+            for (size_t i = 1; i < m; ++i) {
+                match_length += m_gaps[i-1].first + std::min((double)(m_gaps[i-1].second - m_gaps[i-1].first), n / m_occurrences[i]);
+            }
+            estimate = estimate * n / (n + estimate * (match_length - 1));
+            result.estimate = std::max((double)result.lower, std::min((double)result.upper, estimate));
+            return result;
+        }
+};
+
+//! Strategies for executing a variable length gap pattern query.
+enum class vlg_strategy {
+    wt_traversal, //!< Depth-first traversal of the wavelet tree (vlg_iterator).
+    sa_merge,     //!< Extraction and sorting of the SA intervals, followed by a merge.
+    text_scan,    //!< Scan of the stored text for all subpatterns, followed by a merge.
+    anchor_verify //!< Extraction of the rarest subpattern's positions and a scan of the text windows around them.
+};
+
+//! Returns the name of a strategy.
+inline const char* strategy_name(vlg_strategy strategy)
+{
+    switch (strategy) {
+        case vlg_strategy::wt_traversal: return "wt_traversal";
+        case vlg_strategy::sa_merge:     return "sa_merge";
+        case vlg_strategy::text_scan:    return "text_scan";
+        case vlg_strategy::anchor_verify: return "anchor_verify";
+    }
+    return "";
+}
+
+//! Cost-based selection of the strategy used to execute a query.
+/*!
+ * \tparam type_index   Type of index the queries are executed on.
+ *
+ * Each strategy wins in a different regime: The wavelet tree traversal only visits the
+ * parts of the SA intervals which lie close to occurrences of the other subpatterns, but
+ * pays the traversal overhead for each visited position. Extracting and sorting the SA
+ * intervals pays off if all intervals are small, while scanning the text pays off if
+ * the intervals are so large that the text is cheaper to read than the SA values.
+ * If one subpattern is rare, it can anchor the search: Only its SA interval is extracted,
+ * and the other subpatterns are searched in the text windows the gaps allow around
+ * the anchor positions, instead of descending their walkers through all levels.
+ *
+ * The planner estimates the cost of each strategy from the sizes of the SA intervals,
+ * the gap bounds and the text length (see options_type) and executes the cheapest one.
+ * The decision is recorded and can be inspected via last_plan(). The text scan and the
+ * anchor verification are only considered for indexes storing the text (vlg_index).
+ */
+template<typename type_index>
+class vlg_planner
+{
+    public:
+        typedef typename type_index::size_type  size_type;
+        typedef typename type_index::query_type query_type;
+        typedef std::vector<size_type>          match_type;
+
+        //! Weights of the cost model, in units of a text symbol comparison.
+        struct options_type {
+            double rank_cost = 14;    //!< Cost of a rank operation on one wavelet tree level.
+            //! Factor applied to the traversal cost of the visited positions, which accounts
+            //! for the traversal overhead and for nodes shared by several positions.
+            double walker_cost = 0.25;
+            double sort_cost = 1;     //!< Cost per element and comparison when sorting.
+            double scan_cost = 1;     //!< Cost of comparing a text symbol.
+        };
+
+        //! The strategy chosen for a query and the estimated costs of all strategies.
+        struct plan_type {
+            vlg_strategy strategy = vlg_strategy::wt_traversal;
+            //! Estimated cost of each strategy, indexed by vlg_strategy (infinite if unavailable).
+            std::array<double, 4> costs = {{0, 0, 0, 0}};
+            //! SA intervals of the subpatterns, which are reused for the execution.
+            range_vec_type ranges;
+            //! SA intervals of the strings matching each subpattern (several for non-literal ones).
+            std::vector<range_vec_type> intervals;
+            //! Subpattern with the smallest SA intervals, which anchors the verification.
+            size_t anchor = 0;
+
+            double cost(vlg_strategy s) const { return costs[(size_t)s]; }
+        };
+
+    private:
+        const type_index&   m_idx;
+        options_type        m_options;
+        plan_type           m_last_plan;
+        std::vector<std::vector<size_type>> m_positions;
+
+        template<typename t_alphabet, typename t_wt>
+        static bool has_text(const vlg_index<t_alphabet, t_wt>&) { return true; }
+        template<typename t_index>
+        static bool has_text(const t_index&) { return false; }
+
+        // Appends the occurrences of subpattern k starting in [begin, end) to positions, by scanning the text.
+        // Literal subpatterns of byte alphabets are located by memchr on their first symbol.
+        template<typename t_alphabet, typename t_wt>
+        static void scan_text(const vlg_index<t_alphabet, t_wt>& idx, const query_type& query, size_t k,
+                              size_type begin, size_type end, std::vector<size_type>& positions)
+        {
+            const auto& text = idx.text;
+            size_type len = query.subpatterns[k].size();
+            if (len > text.size())
+                return;
+            end = std::min(end, text.size() - len + 1);
+            if (t_alphabet::WIDTH == 8 and query.is_literal(k) and len > 0) {
+                const char* data = (const char*)text.data();
+                const char* sx = (const char*)query.subpatterns[k].data();
+                for (size_type i = begin; i < end; ++i) {
+                    auto hit = (const char*)std::memchr(data + i, sx[0], end - i);
+                    if (hit == nullptr)
+                        return;
+                    i = hit - data;
+                    if (std::memcmp(hit + 1, sx + 1, len - 1) == 0)
+                        positions.push_back(i);
+                }
+                return;
+            }
+            for (size_type i = begin; i < end; ++i) {
+                if (query.matches(k, text.begin() + i))
+                    positions.push_back(i);
+            }
+        }
+        template<typename t_index>
+        static void scan_text(const t_index&, const query_type&, size_t, size_type, size_type, std::vector<size_type>&) { }
+
+        // Appends the occurrences of subpattern k within the gap windows around the sorted positions
+        // of subpattern a to m_positions[k].
+        void scan_windows(const query_type& query, size_t a, size_t k)
+        {
+            // offsets of the occurrences of subpattern k relative to the ones of subpattern a
+            int64_t n = m_idx.wt.size() - 1, lo = 0, hi = 0;
+            for (size_t i = std::min(a, k); i < std::max(a, k); ++i) {
+                lo = std::min(lo + (int64_t)query.gaps[i].first, n);
+                hi = std::min(hi + (int64_t)std::min(query.gaps[i].second, (uint64_t)n), n); // gaps may be unbounded
+            }
+            if (k < a) {
+                std::swap(lo, hi);
+                lo = -lo;
+                hi = -hi;
+            }
+            // the windows are scanned in increasing order, merging overlapping ones
+            int64_t win_begin = 0, win_end = 0;
+            for (auto pos : m_positions[a]) {
+                int64_t b = std::max((int64_t)pos + lo, (int64_t)0), e = std::min((int64_t)pos + hi + 1, n);
+                if (b >= e)
+                    continue;
+                if (b > win_end) {
+                    scan_text(m_idx, query, k, win_begin, win_end, m_positions[k]);
+                    win_begin = b;
+                }
+                win_end = std::max(win_end, e);
+            }
+            scan_text(m_idx, query, k, win_begin, win_end, m_positions[k]);
+        }
+
+        // Appends the matches of an iterator to result.
+        template<typename t_iterator>
+        static void collect(t_iterator&& it, std::vector<match_type>& result)
+        {
+            for (; !it.is_end(); ++it) {
+                match_type match(it.size());
+                for (size_t i = 0; i < it.size(); ++i)
+                    match[i] = it[i];
+                result.push_back(std::move(match));
+            }
+        }
+
+        // Retrieves the matches among the sorted positions in m_positions.
+        std::vector<match_type> match(const query_type& query) const
+        {
+            std::vector<match_type> result;
+            for (const auto& positions : m_positions)
+                if (positions.empty()) return result;
+            match_sorted_positions(m_positions, query.gaps, query.subpatterns.back().size(),
+            [](size_type p) { return p; }, result,
+            m_idx.documents.empty() ? nullptr : &m_idx.documents);
+            return result;
+        }
+
+    public:
+        //! Constructor.
+        vlg_planner(const type_index& idx, const options_type& options = options_type())
+            : m_idx(idx), m_options(options) { }
+
+        //! Estimates the cost of each strategy for the provided pattern and chooses the cheapest one.
+        plan_type plan(const query_type& query) const
+        {
+            plan_type p;
+            vlg_iterator<type_index>::subpattern_ranges(m_idx, query, p.ranges);
+            size_t m = query.subpatterns.size();
+            if (p.ranges.size() < m or empty(p.ranges.back()))
+                return p; // no match, which every strategy detects after the SA interval search
+
+            double n = m_idx.wt.size();
+            double depth = bits::hi(m_idx.wt.size()) + 1;
+            std::vector<double> sizes(m, 0);
+            size_t rarest = 0;
+            p.intervals.resize(m);
+            for (size_t i = 0; i < m; ++i) {
+                vlg_iterator<type_index>::subpattern_intervals(m_idx, query, i, p.intervals[i]);
+                for (const auto& r : p.intervals[i])
+                    sizes[i] += r[1] - r[0] + 1;
+                if (sizes[i] < sizes[rarest])
+                    rarest = i;
+            }
+
+            // The traversal visits the positions of subpattern i which lie in the windows
+            // around the occurrences of the rarest subpattern, assuming uniformly distributed occurrences.
+            // The anchor verification scans the same windows in the text.
+            double visited = 0, total = 0, sort = 0, scanned = 0;
+            for (size_t i = 0; i < m; ++i) {
+                double span = 0;
+                for (size_t k = std::min(i, rarest); k < std::max(i, rarest); ++k)
+                    span += query.gaps[k].second - query.gaps[k].first;
+                visited += std::min(sizes[i], sizes[rarest] * (1 + (span + 1) * sizes[i] / n));
+                if (i != rarest)
+                    scanned += std::min(n, sizes[rarest] * (span + 1));
+                total += sizes[i];
+                sort += sizes[i] * std::log2(sizes[i] + 1);
+            }
+            p.anchor = rarest;
+            auto& o = m_options;
+            p.costs[(size_t)vlg_strategy::wt_traversal] = visited * depth * o.rank_cost * o.walker_cost;
+            p.costs[(size_t)vlg_strategy::sa_merge]     = total * depth * o.rank_cost + sort * o.sort_cost;
+            p.costs[(size_t)vlg_strategy::text_scan]    = has_text(m_idx) ? n * m * o.scan_cost + sort * o.sort_cost
+                                                                           : std::numeric_limits<double>::infinity();
+            p.costs[(size_t)vlg_strategy::anchor_verify] = has_text(m_idx) ? sizes[rarest] * depth * o.rank_cost
+                                                           + sizes[rarest] * std::log2(sizes[rarest] + 1) * o.sort_cost
+                                                           + scanned * o.scan_cost
+                                                           : std::numeric_limits<double>::infinity();
+            p.strategy = (vlg_strategy)(std::min_element(p.costs.begin(), p.costs.end()) - p.costs.begin());
+            return p;
+        }
+
+        //! Retrieves all occurrences of the provided pattern using the cheapest strategy.
+        /*!
+         * Each match is represented by the text positions of its subpatterns.
+         * The result equals the matches reported by vlg_iterator.
+         */
+        std::vector<match_type> locate(const query_type& query)
+        {
+            m_last_plan = plan(query);
+            return locate(query, m_last_plan);
+        }
+
+        //! Retrieves all occurrences of the provided pattern using the strategy of the provided plan.
+        std::vector<match_type> locate(const query_type& query, const plan_type& p)
+        {
+            std::vector<match_type> result;
+            size_t m = query.subpatterns.size();
+            if (p.ranges.size() < m or empty(p.ranges.back()))
+                return result;
+            m_positions.resize(m);
+            switch (p.strategy) {
+                case vlg_strategy::wt_traversal:
+                    if (!query.is_literal())
+                        collect(vlg_iterator<type_index, wt_multi_range_walker<typename type_index::wt_type>>(m_idx, query, p.ranges), result);
+                    else
+                        collect(vlg_iterator<type_index>(m_idx, query, p.ranges), result);
+                    return result;
+                case vlg_strategy::sa_merge:
+                    for (size_t i = 0; i < m; ++i) {
+                        m_positions[i].clear();
+                        for (const auto& r : p.intervals[i])
+                            for (size_type j = r[0]; j <= r[1]; ++j)
+                                m_positions[i].push_back(m_idx.wt[j]);
+                        std::sort(m_positions[i].begin(), m_positions[i].end());
+                    }
+                    break;
+                case vlg_strategy::text_scan:
+                    for (size_t i = 0; i < m; ++i) {
+                        m_positions[i].clear();
+                        scan_text(m_idx, query, i, 0, m_idx.wt.size(), m_positions[i]);
+                    }
+                    break;
+                case vlg_strategy::anchor_verify: {
+                    // Each match has its subpatterns within the gap windows around its anchor position,
+                    // so merging the occurrences within the windows yields the same matches.
+                    auto& anchors = m_positions[p.anchor];
+                    anchors.clear();
+                    for (const auto& r : p.intervals[p.anchor])
+                        for (size_type j = r[0]; j <= r[1]; ++j)
+                            anchors.push_back(m_idx.wt[j]);
+                    std::sort(anchors.begin(), anchors.end());
+                    for (size_t i = 0; i < m; ++i) {
+                        if (i == p.anchor) continue;
+                        m_positions[i].clear();
+                        scan_windows(query, p.anchor, i);
+                    }
+                    break;
+                }
+            }
+            return match(query);
+        }
+
+        //! Returns the plan chosen for the last query executed by locate(query).
+        const plan_type& last_plan() const
+        {
+            return m_last_plan;
+        }
+};
+
+// Removes the files which a construction based on a copy of config added to its cache.
+// If config keeps its files, they are registered in config instead.
+inline void vlg_release_construction_files(cache_config& config, const cache_config& construction_config)
+{
+    for (const auto& key_file : construction_config.file_map) {
+        if (config.file_map.count(key_file.first))
+            continue;
+        if (config.delete_files)
+            sdsl::remove(key_file.second);
+        else
+            config.file_map.insert(key_file);
+    }
+}
+
 template<typename alphabet_tag, typename t_wt>
 void construct(vlg_index<alphabet_tag, t_wt>& idx, const std::string& file, cache_config& config, uint8_t num_bytes)
 {
-    config = sdsl::cache_config(false,".","WCSEARCH_TMP"); // TODO: make better!!! keep in mind: wts needs SA!
+    cache_config construction_config(config);
+    construction_config.delete_files = false; // the wavelet tree is built from the SA file, which is deleted afterwards
 
     int_vector<alphabet_tag::WIDTH> text;
     load_vector_from_file(text, file, num_bytes);
 
     csa_wt<wt_int<>> csa;
-    construct(csa, file, config, num_bytes);
+    construct(csa, file, construction_config, num_bytes);
 
     t_wt wts;
-    construct(wts, cache_file_name(conf::KEY_SA, config));
+    construct(wts, cache_file_name(conf::KEY_SA, construction_config));
 
-    util::delete_all_files(config.file_map);
+    vlg_release_construction_files(config, construction_config);
 
     idx = std::move(vlg_index<alphabet_tag, t_wt>(text, wts));
 }
 
+template<typename alphabet_tag, typename t_csa, typename t_wt>
+void construct(vlg_self_index<alphabet_tag, t_csa, t_wt>& idx, const std::string& file, cache_config& config, uint8_t num_bytes)
+{
+    cache_config construction_config(config);
+    construction_config.delete_files = false; // the wavelet tree is built from the SA file, which is deleted afterwards
+
+    t_csa csa;
+    construct(csa, file, construction_config, num_bytes);
+
+    t_wt wts;
+    construct(wts, cache_file_name(conf::KEY_SA, construction_config));
+
+    vlg_release_construction_files(config, construction_config);
+
+    idx = std::move(vlg_self_index<alphabet_tag, t_csa, t_wt>(std::move(csa), std::move(wts)));
+}
+
 // Retrieves a container representing all occurrences of the provided pattern.
+// The iterators use wt_adaptive_range_walker, so subpatterns with character classes or mismatches
+// matching several SA intervals are traversed jointly, while all others use a plain wt_range_walker.
 template<typename type_index>
-container<vlg_iterator<type_index>> locate(const type_index& idx, const typename type_index::query_type& pattern) {
-    return container<vlg_iterator<type_index>>(
-        vlg_iterator<type_index>(idx, pattern),
-        vlg_iterator<type_index>()
-    );
+container<vlg_iterator<type_index, wt_adaptive_range_walker<typename type_index::wt_type>>>
+locate(const type_index& idx, const typename type_index::query_type& pattern) {
+    typedef vlg_iterator<type_index, wt_adaptive_range_walker<typename type_index::wt_type>> iterator_type;
+    return container<iterator_type>(iterator_type(idx, pattern), iterator_type());
 }
 
-// Retrieves the number of occurrences of the provided pattern.
+// Retrieves a container representing all occurrences of the provided pattern using the memory of a query context.
+// The container is valid until the context is used for the next query.
+template<typename type_index, typename t_walker>
+container<typename vlg_query_context<type_index, t_walker>::iterator_type>
+locate(const type_index& idx, const typename type_index::query_type& pattern, vlg_query_context<type_index, t_walker>& context) {
+    typedef typename vlg_query_context<type_index, t_walker>::iterator_type iterator_type;
+    return container<iterator_type>(context.begin(idx, pattern), iterator_type());
+}
+
+// Reports a match to a sink accepting the positions of all subpatterns as a range [begin, end).
+template<typename t_sink, typename t_pos>
+auto report_match(t_sink& sink, const t_pos* begin, const t_pos* end, int) -> decltype(sink(begin, end), void())
+{
+    sink(begin, end);
+}
+
+// Reports a match to a sink accepting the starting position of the match.
+template<typename t_sink, typename t_pos>
+auto report_match(t_sink& sink, const t_pos* begin, const t_pos*, long) -> decltype(sink(*begin), void())
+{
+    sink(*begin);
+}
+
+// Reports a match to an output iterator by writing the starting position of the match.
+template<typename t_sink, typename t_pos>
+void report_match(t_sink& sink, const t_pos* begin, const t_pos*, ...)
+{
+    *sink = *begin;
+    ++sink;
+}
+
+// Reports all occurrences of the provided pattern to a sink using the memory of a query context.
+/*
+ * The sink is either
+ *  - a callable accepting the positions of all subpatterns of a match as a
+ *    range of pointers [begin, end), which is only valid during the call,
+ *  - a callable accepting the starting position of a match, or
+ *  - an output iterator the starting positions of the matches are written to.
+ * The matches are reported in text order without being buffered. Returns the sink.
+ */
+template<typename type_index, typename t_walker, typename t_sink>
+t_sink locate(const type_index& idx, const typename type_index::query_type& pattern,
+              vlg_query_context<type_index, t_walker>& context, t_sink sink) {
+    typedef typename type_index::size_type size_type;
+    const size_t m = pattern.subpatterns.size();
+    size_type small[8];
+    std::vector<size_type> large(m > 8 ? m : 0);
+    size_type* positions = m > 8 ? large.data() : small;
+    for (auto it = context.begin(idx, pattern); !it.is_end(); ++it) {
+        for (size_t i = 0; i < m; ++i)
+            positions[i] = it[i];
+        report_match(sink, (const size_type*)positions, (const size_type*)positions + m, 0);
+    }
+    return sink;
+}
+
+// Reports all occurrences of the provided pattern to a sink (see above). Returns the sink.
+template<typename type_index, typename t_sink>
+t_sink locate(const type_index& idx, const typename type_index::query_type& pattern, t_sink sink) {
+    if (!pattern.is_literal()) {
+        vlg_query_context<type_index, wt_multi_range_walker<typename type_index::wt_type>> context;
+        return locate(idx, pattern, context, std::move(sink));
+    }
+    vlg_query_context<type_index> context;
+    return locate(idx, pattern, context, std::move(sink));
+}
+
+// Retrieves the occurrences of the provided pattern as (document, offset) pairs of their starting positions.
+// Without document boundaries (see vlg_index::set_documents), the whole text is document 0.
 template<typename type_index>
-typename type_index::size_type count(const type_index& idx, const typename type_index::query_type& pattern) {
+std::vector<std::pair<typename type_index::size_type, typename type_index::size_type>>
+locate_documents(const type_index& idx, const typename type_index::query_type& pattern) {
+    std::vector<std::pair<typename type_index::size_type, typename type_index::size_type>> result;
+    locate(idx, pattern, [&](typename type_index::size_type pos) {
+        result.push_back(idx.documents.document_offset(pos));
+    });
+    return result;
+}
+
+// Retrieves the documents containing an occurrence of the provided pattern (see vlg_index::set_documents).
+/*
+ * After the first match in a document, the search skips to the start of the next
+ * document, so each document is reported once without enumerating its other matches.
+ */
+template<typename type_index>
+std::vector<typename type_index::size_type>
+list_documents(const type_index& idx, const typename type_index::query_type& pattern) {
+    if (!pattern.is_literal())
+        return list_documents(vlg_iterator<type_index, wt_multi_range_walker<typename type_index::wt_type>>(idx, pattern), idx);
+    return list_documents(vlg_iterator<type_index>(idx, pattern), idx);
+}
+
+// Retrieves the documents containing the matches of an iterator, skipping to the next document after the first match.
+template<typename type_index, typename t_walker>
+std::vector<typename type_index::size_type>
+list_documents(vlg_iterator<type_index, t_walker>&& it, const type_index& idx) {
+    const auto& documents = idx.documents;
+    std::vector<typename type_index::size_type> result;
+    while (!it.is_end()) {
+        auto doc = documents.document(it[0]);
+        result.push_back(doc);
+        if (doc + 1 == documents.size())
+            break;
+        it.skip_to(documents.document_begin(doc + 1));
+    }
+    return result;
+}
+
+// Retrieves the documents containing an occurrence of the provided pattern together with
+// the number of occurrences in each document, as (document, frequency) pairs.
+template<typename type_index>
+std::vector<std::pair<typename type_index::size_type, typename type_index::size_type>>
+list_documents_with_frequency(const type_index& idx, const typename type_index::query_type& pattern) {
+    std::vector<std::pair<typename type_index::size_type, typename type_index::size_type>> result;
+    locate(idx, pattern, [&](typename type_index::size_type pos) {
+        auto doc = idx.documents.document(pos);
+        if (result.empty() or result.back().first != doc)
+            result.emplace_back(doc, 0);
+        ++result.back().second;
+    });
+    return result;
+}
+
+// Retrieves containers representing all occurrences of each of the provided patterns.
+/*
+ * Subpatterns shared by several patterns are searched only once. The distinct
+ * subpatterns are searched in lexicographic order, so each search is restricted
+ * to the part of the suffix array behind the previous result (and to the
+ * previous result itself if the previous subpattern is a prefix).
+ * Subpatterns with character classes or mismatches are searched separately. If one of them
+ * matches strings with several SA intervals, the iterators have to use a walker supporting
+ * sets of ranges (like the default wt_adaptive_range_walker); otherwise std::invalid_argument
+ * is thrown before any pattern is searched.
+ */
+template<typename type_index,
+         typename t_walker = wt_adaptive_range_walker<typename type_index::wt_type>>
+std::vector<container<vlg_iterator<type_index, t_walker>>>
+locate_batch(const type_index& idx, const std::vector<typename type_index::query_type>& patterns)
+{
+    typedef typename type_index::size_type size_type;
+    typedef typename type_index::wt_type   wt_type;
+    typedef vlg_iterator<type_index, t_walker> iterator_type;
+    typedef std::pair<size_t, size_t>      subpattern_ref; // (pattern, subpattern)
+    const bool supports_intervals = std::is_constructible<t_walker, const wt_type&, const range_vec_type&,
+                                    wt_node_cache<wt_type>, const typename t_walker::options_type&>::value;
+
+    auto subpattern = [&](const subpattern_ref& ref) -> const typename type_index::query_type::string_type& {
+        return patterns[ref.first].subpatterns[ref.second];
+    };
+    std::vector<subpattern_ref> refs;
+    std::vector<range_vec_type> ranges(patterns.size());
+    range_vec_type intervals;
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        ranges[i].resize(patterns[i].subpatterns.size());
+        for (size_t j = 0; j < patterns[i].subpatterns.size(); ++j) {
+            if (patterns[i].is_literal(j)) {
+                refs.emplace_back(i, j);
+            } else { // non-literal subpatterns are searched separately
+                iterator_type::subpattern_intervals(idx, patterns[i], j, intervals);
+                if (intervals.size() > 1 and !supports_intervals)
+                    throw std::invalid_argument("locate_batch: non-literal subpatterns require a walker supporting "
+                                                "sets of ranges (e.g. wt_multi_range_walker)");
+                ranges[i][j] = intervals.empty() ? range_type{{1, 0}}
+                                                 : range_type{{intervals.front()[0], intervals.back()[1]}};
+            }
+        }
+    }
+    std::sort(refs.begin(), refs.end(), [&](const subpattern_ref& a, const subpattern_ref& b) {
+        const auto& sa = subpattern(a);
+        const auto& sb = subpattern(b);
+        return std::lexicographical_compare(sa.begin(), sa.end(), sb.begin(), sb.end());
+    });
+
+    size_type n = idx.wt.size();
+    size_type lower = 0; // SA intervals of lexicographically larger subpatterns start at or behind lower
+    range_type prev_range = {{0, n-1}};
+    for (size_t k = 0; k < refs.size(); ++k) {
+        const auto& sx = subpattern(refs[k]);
+        auto& range = ranges[refs[k].first][refs[k].second];
+        bool is_prefix = false;
+        if (k > 0) {
+            const auto& prev = subpattern(refs[k-1]);
+            is_prefix = prev.size() <= sx.size() and std::equal(prev.begin(), prev.end(), sx.begin());
+        }
+        if (is_prefix and (empty(prev_range) or subpattern(refs[k-1]).size() == sx.size())) {
+            range = prev_range; // duplicate or extension of a non-occurring subpattern
+            continue;
+        }
+        if (is_prefix)
+            range = idx.sa_interval(sx.begin(), sx.end(), prev_range[0], prev_range[1]);
+        else
+            range = idx.sa_interval(sx.begin(), sx.end(), lower, n-1);
+        if (!empty(range))
+            lower = range[0];
+        prev_range = range;
+    }
+
+    std::vector<container<iterator_type>> result;
+    result.reserve(patterns.size());
+    for (size_t i = 0; i < patterns.size(); ++i)
+        result.emplace_back(iterator_type(idx, patterns[i], ranges[i]), iterator_type());
+    return result;
+}
+
+// Appends the matches starting in a text window [window_begin..window_end) to result, where
+// matches holds the matches found by searching the window independently (sorted by their start).
+/*
+ * A match has to start at or behind next_begin, which is updated for the next window.
+ * If the last match of the previous windows reaches into the window, the window is
+ * searched serially from next_begin using the iterator returned by make_iterator(next_begin)
+ * until the search synchronizes with an entry of matches, which is a match of the serial
+ * search as well as all entries behind it. Positions reported by the iterator are shifted
+ * by offset. The entries of matches are moved into result.
+ */
+template<typename t_match, typename t_make_iterator>
+void stitch_window(std::vector<t_match>& matches, uint64_t window_begin, uint64_t window_end, uint64_t offset,
+                   uint64_t last_subpattern_size, t_make_iterator make_iterator, uint64_t& next_begin,
+                   std::vector<t_match>& result)
+{
+    auto synced = matches.begin();
+    if (next_begin > window_begin) {
+        // previous match overlaps window => search serially until synchronized
+        synced = matches.end();
+        if (next_begin < window_end) {
+            auto it = make_iterator(next_begin);
+            for (; !it.is_end(); ++it) {
+                synced = std::lower_bound(matches.begin(), matches.end(), it[0] + offset,
+                [](const t_match& m, uint64_t pos) { return m[0] < pos; });
+                if (synced != matches.end() and (*synced)[0] == it[0] + offset)
+                    break;
+                synced = matches.end();
+                t_match match(it.size());
+                for (size_t i = 0; i < it.size(); ++i)
+                    match[i] = it[i] + offset;
+                result.push_back(std::move(match));
+                next_begin = result.back().back() + last_subpattern_size;
+            }
+        }
+    }
+    for (; synced != matches.end(); ++synced) {
+        result.push_back(std::move(*synced));
+        next_begin = result.back().back() + last_subpattern_size;
+    }
+}
+
+// Retrieves all occurrences of the provided pattern using multiple threads.
+// Each match is represented by the text positions of its subpatterns.
+/*
+ * The text is split into num_threads windows and each thread collects the
+ * matches starting in its window. Afterwards, window boundaries are stitched
+ * such that the result equals the one of the serial iterator: Whenever the
+ * last match of a window reaches into the next window, the next window is
+ * searched serially until the search synchronizes with the precomputed matches.
+ * Like locate, the iterators use wt_adaptive_range_walker, so patterns with
+ * character classes or mismatches are supported.
+ */
+template<typename type_index>
+std::vector<std::vector<typename type_index::size_type>>
+locate_parallel(const type_index& idx, const typename type_index::query_type& pattern,
+                size_t num_threads = std::thread::hardware_concurrency())
+{
+    typedef typename type_index::size_type        size_type;
+    typedef std::vector<size_type>                 match_type;
+    typedef vlg_iterator<type_index, wt_adaptive_range_walker<typename type_index::wt_type>> iterator_type;
+
+    auto n = idx.wt.size();
+    num_threads = std::max(std::min(num_threads, (size_t)n), (size_t)1);
+    size_type window_size = (n + num_threads - 1) / num_threads;
+    auto window_begin = [&](size_t t) {
+        return std::min((size_type)(t * window_size), n);
+    };
+    auto match_of = [](const iterator_type& it) {
+        match_type match(it.size());
+        for (size_t i = 0; i < it.size(); ++i)
+            match[i] = it[i];
+        return match;
+    };
+
+    // (1) collect matches of each window independently
+    std::vector<std::vector<match_type>> window_matches(num_threads);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            iterator_type it(idx, pattern, window_begin(t), window_begin(t + 1));
+            for (; !it.is_end(); ++it)
+                window_matches[t].push_back(match_of(it));
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    // (2) stitch window boundaries
+    std::vector<match_type> result;
+    uint64_t next_begin = 0; // a match has to start at or behind this position
+    for (size_t t = 0; t < num_threads; ++t) {
+        stitch_window(window_matches[t], window_begin(t), window_begin(t + 1), 0, pattern.subpatterns.back().size(),
+        [&](size_type begin) {
+            return iterator_type(idx, pattern, begin, window_begin(t + 1));
+        }, next_begin, result);
+    }
+    return result;
+}
+
+// Retrieves the number of occurrences of the provided pattern using the memory of a query context.
+template<typename type_index, typename t_walker>
+typename type_index::size_type count(const type_index& idx, const typename type_index::query_type& pattern,
+                                     vlg_query_context<type_index, t_walker>& context) {
     typename type_index::size_type result = 0;
-    auto cont = locate(idx, pattern);
-    for (auto it = cont.begin(); it != cont.end(); ++it)
+    for (auto it = context.begin(idx, pattern); !it.is_end(); ++it)
         ++result;
     return result;
 }
 
+// Retrieves the number of occurrences of the provided pattern.
+// The traversal state of the walkers is kept in place, so counting does not touch the heap after setup.
+template<typename type_index>
+typename type_index::size_type count(const type_index& idx, const typename type_index::query_type& pattern) {
+    if (!pattern.is_literal()) {
+        vlg_query_context<type_index, wt_multi_range_walker<typename type_index::wt_type>> context;
+        return count(idx, pattern, context);
+    }
+    vlg_query_context<type_index> context;
+    return count(idx, pattern, context);
+}
+
+// Estimates the number of occurrences of the provided pattern, expanding at most budget wavelet tree nodes.
+// The result contains bounds on the number of occurrences (see vlg_level_engine::estimate_count).
+template<typename type_index>
+vlg_count_estimate estimate_count(const type_index& idx, const typename type_index::query_type& pattern, size_t budget) {
+    vlg_level_engine<type_index> engine(idx);
+    return engine.estimate_count(pattern, budget);
+}
+
 } // end namespace sdsl
 #endif
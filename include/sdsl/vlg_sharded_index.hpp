@@ -0,0 +1,286 @@
+/* sdsl - succinct data structures library
+    Copyright (C) 2016 Simon Gog
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+/*! \file vlg_sharded_index.hpp
+    \brief vlg_sharded_index.hpp contains a variable length gap pattern index
+            which splits the text into overlapping shards indexed by vlg_index.
+*/
+#ifndef INCLUDED_SDSL_VLG_SHARDED_INDEX
+#define INCLUDED_SDSL_VLG_SHARDED_INDEX
+
+#include "vlg_index.hpp"
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+//! Namespace for the succinct data structure library.
+namespace sdsl
+{
+
+//! A vlg_index split into overlapping shards.
+/*!
+ * \tparam alphabet_tag   Type of alphabet used by the indexed text and thus also the index.
+ * \tparam t_wt           Wavelet tree used for storing the suffix arrays.
+ *
+ * The text is split into shards of shard_size symbols. Each shard additionally contains
+ * the following overlap symbols of the text, so every match spanning at most overlap
+ * symbols lies completely within the shard its first subpattern starts in. The shards are
+ * indexed by separate vlg_index instances, which are built in parallel. As the suffix array
+ * of a shard only addresses the shard, its wavelet tree uses log(shard_size + overlap)
+ * instead of log(n) bits per symbol.
+ *
+ * A query collects the matches starting in each shard in parallel. Afterwards, the shard
+ * boundaries are stitched as in locate_parallel, such that the matches are exactly the ones
+ * a vlg_index over the whole text reports. Queries whose matches may span more than overlap
+ * symbols (including queries with unbounded gaps) are rejected.
+ * Document boundaries (see vlg_index::set_documents) are not supported.
+ */
+template<typename alphabet_tag=byte_alphabet_tag,
+         typename t_wt=wt_int<
+             bit_vector_il<>,
+             rank_support_il<>>>
+class vlg_sharded_index
+{
+    public:
+        typedef vlg_index<alphabet_tag, t_wt>      shard_type;
+        typedef typename shard_type::size_type     size_type;
+        typedef typename shard_type::text_type     text_type;
+        typedef typename shard_type::query_type    query_type;
+        typedef std::vector<size_type>             match_type;
+
+    private:
+        std::vector<shard_type> m_shards;
+        size_type               m_size       = 0;
+        size_type               m_shard_size = 1;
+        size_type               m_overlap    = 0;
+        size_t                  m_threads;
+
+        // Calls f(s) for each shard s using the worker threads.
+        template<typename t_function>
+        void for_each_shard(t_function f) const
+        {
+            std::atomic<size_t> next(0);
+            auto work = [&]() {
+                for (size_t s; (s = next++) < m_shards.size();)
+                    f(s);
+            };
+            std::vector<std::thread> threads;
+            for (size_t t = 1; t < std::min(m_threads, m_shards.size()); ++t)
+                threads.emplace_back(work);
+            work();
+            for (auto& thread : threads)
+                thread.join();
+        }
+
+        size_type shard_begin(size_t s) const
+        {
+            return std::min((size_type)s * m_shard_size, m_size);
+        }
+
+        template<typename t_walker>
+        std::vector<match_type> locate(const query_type& query) const
+        {
+            // (1) collect the matches starting in each shard independently
+            std::vector<std::vector<match_type>> shard_matches(m_shards.size());
+            for_each_shard([&](size_t s) {
+                size_type begin = shard_begin(s);
+                vlg_iterator<shard_type, t_walker> it(m_shards[s], query, 0, shard_begin(s + 1) - begin);
+                for (; !it.is_end(); ++it) {
+                    match_type match(it.size());
+                    for (size_t i = 0; i < it.size(); ++i)
+                        match[i] = it[i] + begin;
+                    shard_matches[s].push_back(std::move(match));
+                }
+            });
+            // (2) stitch shard boundaries
+            std::vector<match_type> result;
+            uint64_t next_begin = 0; // a match has to start at or behind this position
+            for (size_t s = 0; s < m_shards.size(); ++s) {
+                size_type begin = shard_begin(s), end = shard_begin(s + 1);
+                stitch_window(shard_matches[s], begin, end, begin, query.subpatterns.back().size(),
+                [&](size_type pos) {
+                    return vlg_iterator<shard_type, t_walker>(m_shards[s], query, pos - begin, end - begin);
+                }, next_begin, result);
+            }
+            return result;
+        }
+
+    public:
+        //! Default constructor.
+        /*!
+         * \param num_threads  Number of threads used for building the shards and for queries.
+         */
+        vlg_sharded_index(size_t num_threads = std::thread::hardware_concurrency())
+            : m_threads(std::max(num_threads, (size_t)1)) { }
+
+        //! Constructor.
+        /*!
+         * \param text         The text to index.
+         * \param shard_size   Number of text positions a shard is responsible for.
+         * \param overlap      Maximum number of symbols a match may span.
+         * \param num_threads  Number of threads used for building the shards and for queries.
+         */
+        vlg_sharded_index(const text_type& text, size_type shard_size, size_type overlap,
+                          size_t num_threads = std::thread::hardware_concurrency())
+            : m_size(text.size()), m_shard_size(std::max(shard_size, (size_type)1)),
+              m_overlap(overlap), m_threads(std::max(num_threads, (size_t)1))
+        {
+            m_shards.resize((m_size + m_shard_size - 1) / m_shard_size);
+            for_each_shard([&](size_t s) {
+                size_type begin = shard_begin(s), end = std::min(shard_begin(s + 1) + m_overlap, m_size);
+                if (alphabet_tag::WIDTH == 8) { // byte texts are stored as plain arrays
+                    std::string bytes(text.begin() + begin, text.begin() + end);
+                    construct_im(m_shards[s], bytes, 1);
+                } else {
+                    text_type shard_text(end - begin);
+                    std::copy(text.begin() + begin, text.begin() + end, shard_text.begin());
+                    construct_im(m_shards[s], shard_text, 0);
+                }
+            });
+        }
+
+        //! Length of the indexed text.
+        size_type size() const
+        {
+            return m_size;
+        }
+
+        //! Number of shards.
+        size_t shards() const
+        {
+            return m_shards.size();
+        }
+
+        //! Maximum number of symbols a match may span.
+        size_type overlap() const
+        {
+            return m_overlap;
+        }
+
+        //! Returns whether the matches of the provided pattern lie within a shard.
+        bool supports(const query_type& query) const
+        {
+            uint64_t span = query.subpatterns.back().size();
+            for (const auto& gap : query.gaps)
+                span = std::min(span + std::min(gap.second, (uint64_t)m_size), (uint64_t)m_size + 1); // gaps may be unbounded
+            return span <= m_overlap;
+        }
+
+        //! Extracts the text T[begin..end].
+        /*!
+         * \pre \f$begin <= end\f$ and \f$ end < size() \f$
+         */
+        text_type extract(size_type begin, size_type end) const
+        {
+            text_type result(end - begin + 1);
+            for (size_type pos = begin; pos <= end;) {
+                size_t s = pos / m_shard_size;
+                size_type shard_end = std::min(shard_begin(s + 1), end + 1);
+                const auto& text = m_shards[s].text;
+                std::copy(text.begin() + (pos - shard_begin(s)), text.begin() + (shard_end - shard_begin(s)),
+                          result.begin() + (pos - begin));
+                pos = shard_end;
+            }
+            return result;
+        }
+
+        //! Retrieves all occurrences of the provided pattern.
+        /*!
+         * \throws std::invalid_argument if the matches may span more than overlap() symbols.
+         */
+        std::vector<match_type> locate(const query_type& query) const
+        {
+            if (!supports(query))
+                throw std::invalid_argument("vlg_sharded_index: pattern may span more symbols than the shards overlap");
+            if (!query.is_literal())
+                return locate<wt_multi_range_walker<t_wt>>(query);
+            return locate<wt_fixed_range_walker<t_wt>>(query);
+        }
+
+        //! Reports all occurrences of the provided pattern to a sink.
+        /*!
+         * The sink is called for each match as in locate(idx, pattern, sink) of vlg_index. Returns the sink.
+         * Unlike there, the matches are not streamed: as the shard boundaries can only be stitched after
+         * all shards have been searched, all matches are collected (as in locate(query)) before the
+         * first one is reported.
+         */
+        template<typename t_sink>
+        t_sink locate(const query_type& query, t_sink sink) const
+        {
+            for (const auto& match : locate(query))
+                report_match(sink, match.data(), match.data() + match.size(), 0);
+            return sink;
+        }
+
+        //! Retrieves the number of occurrences of the provided pattern.
+        size_type count(const query_type& query) const
+        {
+            return locate(query).size();
+        }
+
+        //! Serializes the data structure into the given ostream
+        size_type serialize(std::ostream& out, structure_tree_node* v=nullptr, std::string name="")const
+        {
+            structure_tree_node* child = structure_tree::add_child(v, name, util::class_name(*this));
+            size_type written_bytes = 0;
+            written_bytes += write_member(m_size, out, child, "size");
+            written_bytes += write_member(m_shard_size, out, child, "shard_size");
+            written_bytes += write_member(m_overlap, out, child, "overlap");
+            for (const auto& shard : m_shards)
+                written_bytes += shard.serialize(out, child, "shard");
+            structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        //! Loads the data structure from the given istream.
+        void load(std::istream& in)
+        {
+            read_member(m_size, in);
+            read_member(m_shard_size, in);
+            read_member(m_overlap, in);
+            m_shards = std::vector<shard_type>((m_size + m_shard_size - 1) / m_shard_size);
+            for (auto& shard : m_shards)
+                shard.load(in);
+        }
+};
+
+// Retrieves all occurrences of the provided pattern in a sharded index.
+template<typename alphabet_tag, typename t_wt>
+std::vector<std::vector<typename vlg_sharded_index<alphabet_tag, t_wt>::size_type>>
+locate_parallel(const vlg_sharded_index<alphabet_tag, t_wt>& idx,
+                const typename vlg_sharded_index<alphabet_tag, t_wt>::query_type& pattern) {
+    return idx.locate(pattern);
+}
+
+// Reports all occurrences of the provided pattern in a sharded index to a sink. Returns the sink.
+template<typename alphabet_tag, typename t_wt, typename t_sink>
+t_sink locate(const vlg_sharded_index<alphabet_tag, t_wt>& idx,
+              const typename vlg_sharded_index<alphabet_tag, t_wt>::query_type& pattern, t_sink sink) {
+    return idx.locate(pattern, std::move(sink));
+}
+
+// Retrieves the number of occurrences of the provided pattern in a sharded index.
+template<typename alphabet_tag, typename t_wt>
+typename vlg_sharded_index<alphabet_tag, t_wt>::size_type
+count(const vlg_sharded_index<alphabet_tag, t_wt>& idx,
+      const typename vlg_sharded_index<alphabet_tag, t_wt>::query_type& pattern) {
+    return idx.count(pattern);
+}
+
+} // end namespace sdsl
+#endif
@@ -35,6 +35,8 @@
 #include "wt_huff.hpp"
 #include "wt_hutu.hpp"
 #include "wt_int.hpp"
+#include "wt_int_dfs.hpp"
+#include "wt_int_kary.hpp"
 #include "wm_int.hpp"
 #include "wt_rlmn.hpp"
 #include "wt_ap.hpp"
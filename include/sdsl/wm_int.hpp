@@ -780,6 +780,40 @@ class wm_int
             };
         }
 
+        //! Returns the two child nodes of an inner node and the mapping of a range to them
+        /*! \param v An inner node of an wavelet tree.
+         *  \param r A ranges [s,e], such that [s,e] is
+         *           contained in v=[v_s,v_e].
+         *  \return An array of (node, range) pairs (left child, right child).
+         *          Yields the same as expand(v) and expand(v, r),
+         *          but each rank is calculated only once.
+         *  \pre !is_leaf(v) and s>=v_s and e<=v_e
+         */
+        std::array<std::pair<node_type, range_type>, 2>
+        expand_with_range(const node_type& v, const range_type& r) const
+        {
+            auto v_sp_rank  = m_tree_rank(v.offset);
+            auto v_ep_rank  = m_tree_rank(v.offset + v.size);
+            auto sp_rank    = r[0] == 0 ? v_sp_rank : m_tree_rank(v.offset + r[0]);
+            auto ep_rank    = r[1] + 1 == v.size ? v_ep_rank : m_tree_rank(v.offset + r[1] + 1);
+            auto ones       = v_ep_rank - v_sp_rank;                  // ones in [b..size)
+            auto ones_p     = v_sp_rank - m_rank_level[v.level];      // ones in [level_b..b)
+            auto right_size = ep_rank - sp_rank;
+            auto left_size  = (r[1]-r[0]+1)-right_size;
+
+            auto right_sp = sp_rank - v_sp_rank;
+            auto left_sp  = r[0] - right_sp;
+
+            return {{{node_type((v.level+1)*m_size + (v.offset - v.level*m_size) - ones_p,
+                                v.size - ones, v.level + 1, v.sym<<1),
+                      {{left_sp, left_sp + left_size - 1}}},
+                    {node_type((v.level+1)*m_size + m_zero_cnt[v.level] + ones_p,
+                               ones, v.level + 1, (v.sym<<1)|1),
+                     {{right_sp, right_sp + right_size - 1}}}
+                }
+            };
+        }
+
         //! return the path to the leaf for a given symbol
         std::pair<uint64_t,uint64_t> path(value_type c) const
         {
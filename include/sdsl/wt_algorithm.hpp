@@ -85,10 +85,9 @@ count(const t_wt& wt, const range_type& x_range, const range_type& y_range)
         auto x_range = std::get<1>(s.top());
         s.pop();
         if (!wt.is_leaf(v)) {
-            auto child_v = wt.expand(v);
-            auto child_r = wt.expand(v, x_range);
-            for (size_t i=0, j=child_v.size()-1; i < child_v.size(); ++i,--j) {
-                push_node(child_v[j], child_r[j]);
+            auto child = wt.expand_with_range(v, x_range);
+            for (size_t i=0, j=child.size()-1; i < child.size(); ++i,--j) {
+                push_node(child[j].first, child[j].second);
             }
         }
     }
@@ -154,14 +153,13 @@ class map_to_sorted_iterator
                 auto lex_sml = std::get<2>(m_stack.top());
                 m_stack.pop();
                 if (!m_wt->is_leaf(v)) {
-                    auto child_v = m_wt->expand(v);
-                    auto child_r = m_wt->expand(v, x_range);
+                    auto child = m_wt->expand_with_range(v, x_range);
                     for (int i=1; i >= 0; --i) {
-                        if (size(child_r[i]) > 0) {
+                        if (size(child[i].second) > 0) {
                             if (i==1)
-                                cond_push(child_v[i], child_r[i], lex_sml+m_wt->size(child_v[0]));
+                                cond_push(child[i].first, child[i].second, lex_sml+m_wt->size(child[0].first));
                             else
-                                cond_push(child_v[i], child_r[i], lex_sml);
+                                cond_push(child[i].first, child[i].second, lex_sml);
                         }
                     }
                 } else {
@@ -258,13 +256,12 @@ class y_iterator
                     m_valid = true;
                     break;
                 } else {
-                    auto child_v = m_wt->expand(v);
-                    auto child_r = m_wt->expand(v, r);
-                    if (!sdsl::empty(std::get<1>(child_r))) {
-                        m_stack.emplace(std::get<1>(child_v), std::get<1>(child_r));
+                    auto child = m_wt->expand_with_range(v, r);
+                    if (!sdsl::empty(child[1].second)) {
+                        m_stack.emplace(child[1].first, child[1].second);
                     }
-                    if (!sdsl::empty(std::get<0>(child_r))) {
-                        m_stack.emplace(std::get<0>(child_v), std::get<0>(child_r));
+                    if (!sdsl::empty(child[0].second)) {
+                        m_stack.emplace(child[0].first, child[0].second);
                     }
                 }
             }
@@ -370,14 +367,13 @@ class yoff_iterator
                     m_valid = true;
                     break;
                 } else {
-                    auto child_v = m_wt->expand(v);
-                    auto child_r = m_wt->expand(v, r);
-                    if (!sdsl::empty(std::get<1>(child_r))) {
-                        m_stack.emplace(std::get<1>(child_v), std::get<1>(child_r),
-                                        lex_smaller + m_wt->size(std::get<0>(child_v)));
+                    auto child = m_wt->expand_with_range(v, r);
+                    if (!sdsl::empty(child[1].second)) {
+                        m_stack.emplace(child[1].first, child[1].second,
+                                        lex_smaller + m_wt->size(child[0].first));
                     }
-                    if (!sdsl::empty(std::get<0>(child_r))) {
-                        m_stack.emplace(std::get<0>(child_v), std::get<0>(child_r), lex_smaller);
+                    if (!sdsl::empty(child[0].second)) {
+                        m_stack.emplace(child[0].first, child[0].second, lex_smaller);
                     }
                 }
             }
@@ -519,17 +515,16 @@ quantile_freq(const t_wt& wt, typename t_wt::size_type lb,
     range_type r {{lb,rb}};
 
     while (!wt.is_leaf(v)) {
-        auto child        = wt.expand(v);
-        auto child_ranges = wt.expand(v, r);
-        auto num_zeros    = size(get<0>(child_ranges));
+        auto child     = wt.expand_with_range(v, r);
+        auto num_zeros = size(child[0].second);
 
         if (q >= num_zeros) {
             q -= num_zeros;
-            v = get<1>(child);
-            r = get<1>(child_ranges);
+            v = child[1].first;
+            r = child[1].second;
         } else {
-            v = get<0>(child);
-            r = get<0>(child_ranges);
+            v = child[0].first;
+            r = child[0].second;
         }
     }
     return {wt.sym(v), size(r)};
@@ -550,15 +545,14 @@ _interval_symbols_rec(const t_wt& wt, range_type r,
         rank_c_j[k] = r[1]+1;
         cs[k++] = wt.sym(v);
     } else {
-        auto child        = wt.expand(v);
-        auto child_ranges = wt.expand(v, r);
-        if (!empty(get<0>(child_ranges))) {
-            _interval_symbols_rec(wt, get<0>(child_ranges), k, cs, rank_c_i,
-                                  rank_c_j, get<0>(child));
+        auto child = wt.expand_with_range(v, r);
+        if (!empty(child[0].second)) {
+            _interval_symbols_rec(wt, child[0].second, k, cs, rank_c_i,
+                                  rank_c_j, child[0].first);
         }
-        if (!empty(get<1>(child_ranges))) {
-            _interval_symbols_rec(wt, get<1>(child_ranges), k, cs, rank_c_i,
-                                  rank_c_j, get<1>(child));
+        if (!empty(child[1].second)) {
+            _interval_symbols_rec(wt, child[1].second, k, cs, rank_c_i,
+                                  rank_c_j, child[1].first);
         }
     }
 }
@@ -970,19 +964,18 @@ restricted_unique_range_values(const t_wt& wt,
         if (wt.is_leaf(node)) {
             unique_values.emplace_back(wt.sym(node));
         } else {
-            auto children = wt.expand(node);
+            auto children = wt.expand_with_range(node,range);
             auto left_path = node_path<<1ULL;
             auto right_path = (node_path<<1ULL)|1ULL;
-            auto child_ranges = wt.expand(node,range);
             if (compare_path(right_path,node_level+1,upper_y_bound_path) < 1) {
-                auto right_child = std::get<1>(children);
-                auto right_range = std::get<1>(child_ranges);
+                auto right_child = children[1].first;
+                auto right_range = children[1].second;
                 if (!sdsl::empty(right_range))
                     stack.emplace(right_child,right_range,right_path,node_level+1);
             }
             if (compare_path(left_path,node_level+1,lower_y_bound_path) > -1) {
-                auto left_child = std::get<0>(children);
-                auto left_range = std::get<0>(child_ranges);
+                auto left_child = children[0].first;
+                auto left_range = children[0].second;
                 if (!sdsl::empty(left_range))
                     stack.emplace(left_child,left_range,left_path,node_level+1);
             }
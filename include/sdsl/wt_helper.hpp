@@ -9,6 +9,7 @@
 #include <vector>
 #include <utility>
 #include <array>
+#include <tuple>
 
 namespace sdsl
 {
@@ -696,10 +697,13 @@ struct wt_node_cache {
     typedef typename wt_type::node_type node_type;
     typedef typename wt_type::size_type size_type;
 
-    const node_type node;
-    size_type range_begin;
-    size_type range_end;
-    bool is_leaf;
+    node_type node = node_type();
+    size_type range_begin = 0;
+    size_type range_end = 0;
+    bool is_leaf = true;
+
+    //! Default constructor
+    wt_node_cache() = default;
 
     //! Constructor, precalculates frequently used values.
     wt_node_cache(
@@ -714,15 +718,66 @@ struct wt_node_cache {
     }
 };
 
+//! A stack of fixed capacity, which stores its elements in place instead of on the heap.
+/*!
+ * \tparam T          Type of the elements.
+ * \tparam t_capacity Maximal number of elements on the stack.
+ */
+template<typename T, size_t t_capacity>
+class fixed_stack
+{
+    private:
+        std::array<T, t_capacity> m_data;
+        size_t                    m_size = 0;
+
+    public:
+        //! No-op, the capacity is fixed.
+        void reserve(size_t) { }
+
+        bool empty() const
+        {
+            return m_size == 0;
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        T& back()
+        {
+            return m_data[m_size-1];
+        }
+
+        const T& back() const
+        {
+            return m_data[m_size-1];
+        }
+
+        void pop_back()
+        {
+            --m_size;
+        }
+
+        template<class... t_args>
+        void emplace_back(t_args&&... args)
+        {
+            assert(m_size < t_capacity);
+            m_data[m_size++] = T(std::forward<t_args>(args)...);
+        }
+};
+
 //! Provides a convenient way of traversing a wavelet tree from left to right.
 /*!
  * \tparam wt_type   Type of wavelet tree to traverse.
+ * \tparam t_stack   Type of the stack storing the state of the traversal.
  *
  * This class keeps track of the state required to perform a depth-first traversal
  * of a wavelet tree. Furthermore it provides methods to traverse the tree in
  * various ways.
  */
-template<typename wt_type>
+template<typename wt_type,
+         typename t_stack = std::vector<std::pair<range_type, wt_node_cache<wt_type>>>>
 class wt_range_walker
 {
         static_assert(std::is_same<typename index_tag<wt_type>::type, wt_tag>::value,
@@ -731,11 +786,15 @@ class wt_range_walker
     private:
         typedef wt_node_cache<wt_type> node_type;
         const wt_type& wt;
-        std::vector<std::pair<range_type,node_type>> dfs_stack;
+        t_stack dfs_stack;
 
     public:
+        //! Options of the traversal (none).
+        struct options_type { };
+
         //! Constructor
-        wt_range_walker(const wt_type& wt, range_type initial_range, node_type root_node)
+        wt_range_walker(const wt_type& wt, range_type initial_range, node_type root_node,
+                        const options_type& = options_type())
             : wt(wt)
         {
             dfs_stack.reserve(8 * sizeof(typename wt_type::size_type)); // = max. depth
@@ -749,7 +808,7 @@ class wt_range_walker
         }
 
         //! Returns the wavelet tree node currently pointed at by the walker.
-        inline node_type current_node() const
+        inline const node_type& current_node() const
         {
             return dfs_stack.back().second;
         }
@@ -765,12 +824,356 @@ class wt_range_walker
         {
             auto top = dfs_stack.back(); dfs_stack.pop_back();
             auto& node = top.second;
-            auto children = wt.expand(node.node);
-            auto exp_range = wt.expand(node.node, top.first);
-            if (!empty(exp_range[1]))
-                dfs_stack.emplace_back(exp_range[1], node_type(children[1], wt));
-            if (!empty(exp_range[0]))
-                dfs_stack.emplace_back(exp_range[0], node_type(children[0], wt));
+            auto children = wt.expand_with_range(node.node, top.first);
+            for (size_t c = children.size(); c > 0; --c) { // leftmost child on top
+                if (!empty(children[c-1].second))
+                    dfs_stack.emplace_back(children[c-1].second, node_type(children[c-1].first, wt));
+            }
+        }
+
+        //! Traverse to the next leaf. Returns false if there is no more, i.e. the traversal has finished.
+        inline bool next_leaf()
+        {
+            if (has_more() and current_node().is_leaf)
+                next_right();
+            while (has_more() and !current_node().is_leaf)
+                next_down();
+            return has_more();
+        }
+};
+
+//! Provides a left-to-right traversal of a wavelet tree restricted to a set of ranges.
+/*!
+ * \tparam wt_type   Type of wavelet tree to traverse.
+ *
+ * In contrast to wt_range_walker, each node is visited with the set of ranges which
+ * are mapped into it from the initial ranges. Hence, the positions (i.e. values) of
+ * several disjoint ranges are traversed jointly in increasing order. The ranges of
+ * the nodes on the traversal stack are stored consecutively in a single vector.
+ */
+template<typename wt_type>
+class wt_multi_range_walker
+{
+        static_assert(std::is_same<typename index_tag<wt_type>::type, wt_tag>::value,
+                      "First template argument has to be a wavelet tree.");
+
+    private:
+        typedef wt_node_cache<wt_type> node_type;
+
+        struct entry_type {
+            node_type node;
+            size_t    ranges_begin; // ranges of node are m_ranges[ranges_begin..m_ranges.size()-1] if on top
+        };
+
+        static const size_t arity = std::tuple_size<decltype(std::declval<const wt_type&>().expand_with_range(
+                                        std::declval<const typename wt_type::node_type&>(),
+                                        std::declval<const range_type&>()))>::value;
+
+        const wt_type&                               wt;
+        std::vector<entry_type>                      dfs_stack;
+        range_vec_type                               m_ranges;
+        std::array<range_vec_type, arity>            m_child_ranges;
+        std::array<typename wt_type::node_type, arity> m_child_nodes;
+
+        void push(const node_type& node, const range_vec_type& ranges)
+        {
+            dfs_stack.push_back({node, m_ranges.size()});
+            m_ranges.insert(m_ranges.end(), ranges.begin(), ranges.end());
+        }
+
+    public:
+        //! Options of the traversal (none).
+        struct options_type { };
+
+        //! Constructor
+        wt_multi_range_walker(const wt_type& wt, const range_vec_type& initial_ranges, node_type root_node,
+                              const options_type& = options_type())
+            : wt(wt)
+        {
+            range_vec_type ranges;
+            for (const auto& r : initial_ranges)
+                if (!empty(r)) ranges.push_back(r);
+            if (!ranges.empty())
+                push(root_node, ranges);
+        }
+
+        //! Constructor
+        wt_multi_range_walker(const wt_type& wt, range_type initial_range, node_type root_node,
+                              const options_type& options = options_type())
+            : wt_multi_range_walker(wt, range_vec_type(1, initial_range), root_node, options) { }
+
+        //! Returns whether the traversal has not yet reached the end of the wavelet tree.
+        inline bool has_more() const
+        {
+            return !dfs_stack.empty();
+        }
+
+        //! Returns the wavelet tree node currently pointed at by the walker.
+        inline const node_type& current_node() const
+        {
+            return dfs_stack.back().node;
+        }
+
+        //! Traverse to the next node, discarding any child nodes of the current node.
+        inline void next_right()
+        {
+            m_ranges.resize(dfs_stack.back().ranges_begin);
+            dfs_stack.pop_back();
+        }
+
+        //! Traverse to the first non-empty child node of the current node.
+        inline void next_down()
+        {
+            auto top = dfs_stack.back(); dfs_stack.pop_back();
+            for (auto& ranges : m_child_ranges)
+                ranges.clear();
+            for (size_t k = top.ranges_begin; k < m_ranges.size(); ++k) {
+                auto children = wt.expand_with_range(top.node.node, m_ranges[k]);
+                for (size_t c = 0; c < arity; ++c) {
+                    m_child_nodes[c] = children[c].first;
+                    if (!empty(children[c].second))
+                        m_child_ranges[c].push_back(children[c].second);
+                }
+            }
+            m_ranges.resize(top.ranges_begin);
+            for (size_t c = arity; c > 0; --c) { // leftmost child on top
+                if (!m_child_ranges[c-1].empty())
+                    push(node_type(m_child_nodes[c-1], wt), m_child_ranges[c-1]);
+            }
+        }
+
+        //! Traverse to the next leaf. Returns false if there is no more, i.e. the traversal has finished.
+        inline bool next_leaf()
+        {
+            if (has_more() and current_node().is_leaf)
+                next_right();
+            while (has_more() and !current_node().is_leaf)
+                next_down();
+            return has_more();
+        }
+};
+
+//! A walker traversing a single range like wt_range_walker and a set of ranges like wt_multi_range_walker.
+/*!
+ * \tparam wt_type   Type of wavelet tree to traverse.
+ *
+ * The walker is chosen when the walker is constructed, so single ranges are traversed
+ * without the overhead of maintaining sets of ranges.
+ */
+template<typename wt_type>
+class wt_adaptive_range_walker
+{
+    private:
+        typedef wt_node_cache<wt_type> node_type;
+
+        bool                           m_multi;
+        wt_range_walker<wt_type>       m_single_walker;
+        wt_multi_range_walker<wt_type> m_multi_walker;
+
+    public:
+        //! Options of the traversal (none).
+        struct options_type { };
+
+        //! Constructor
+        wt_adaptive_range_walker(const wt_type& wt, range_type initial_range, node_type root_node,
+                                 const options_type& = options_type())
+            : m_multi(false), m_single_walker(wt, initial_range, root_node),
+              m_multi_walker(wt, range_vec_type(), root_node) { }
+
+        //! Constructor
+        wt_adaptive_range_walker(const wt_type& wt, const range_vec_type& initial_ranges, node_type root_node,
+                                 const options_type& = options_type())
+            : m_multi(initial_ranges.size() != 1),
+              m_single_walker(wt, m_multi ? range_type{{1, 0}} : initial_ranges[0], root_node),
+              m_multi_walker(wt, m_multi ? initial_ranges : range_vec_type(), root_node) { }
+
+        //! Returns whether the traversal has not yet reached the end of the wavelet tree.
+        inline bool has_more() const
+        {
+            return m_multi ? m_multi_walker.has_more() : m_single_walker.has_more();
+        }
+
+        //! Returns the wavelet tree node currently pointed at by the walker.
+        inline const node_type& current_node() const
+        {
+            return m_multi ? m_multi_walker.current_node() : m_single_walker.current_node();
+        }
+
+        //! Traverse to the next node, discarding any child nodes of the current node.
+        inline void next_right()
+        {
+            if (m_multi) m_multi_walker.next_right(); else m_single_walker.next_right();
+        }
+
+        //! Traverse to the first non-empty child node of the current node.
+        inline void next_down()
+        {
+            if (m_multi) m_multi_walker.next_down(); else m_single_walker.next_down();
+        }
+
+        //! Traverse to the next leaf. Returns false if there is no more, i.e. the traversal has finished.
+        inline bool next_leaf()
+        {
+            return m_multi ? m_multi_walker.next_leaf() : m_single_walker.next_leaf();
+        }
+};
+
+//! Number of children of an inner node of a wavelet tree, i.e., the size of the result of expand_with_range.
+template<typename wt_type>
+struct wt_arity {
+    typedef decltype(std::declval<const wt_type&>().expand_with_range(
+                         std::declval<const typename wt_type::node_type&>(),
+                         std::declval<const range_type&>())) children_type;
+
+    static constexpr size_t value = std::tuple_size<children_type>::value;
+};
+
+//! Maximal number of nodes on the stack of a depth-first traversal of a wavelet tree.
+/*!
+ * The traversal holds at most arity-1 nodes per level plus the current node.
+ */
+template<typename wt_type>
+struct wt_dfs_stack_capacity {
+    static constexpr size_t log2_ceil(size_t x) {
+        return x <= 1 ? 0 : 1 + log2_ceil((x+1)/2);
+    }
+
+    static constexpr size_t arity     = wt_arity<wt_type>::value;
+    static constexpr size_t max_depth = (8*sizeof(typename wt_type::size_type) + log2_ceil(arity) - 1) / log2_ceil(arity);
+    static constexpr size_t value     = (arity-1)*max_depth + 1;
+};
+
+//! A wt_range_walker whose traversal stack does not require heap memory.
+/*!
+ * The capacity of the stack is determined by the maximal depth and the arity of the wavelet tree.
+ */
+template<typename wt_type>
+using wt_fixed_range_walker = wt_range_walker<wt_type,
+      fixed_stack<std::pair<range_type, wt_node_cache<wt_type>>, wt_dfs_stack_capacity<wt_type>::value>>;
+
+//! A range walker which extracts all leaves below nodes with small ranges at once.
+/*!
+ * \tparam wt_type   Type of wavelet tree to traverse.
+ * \tparam t_stack   Type of the stack storing the state of the traversal.
+ *
+ * The walker behaves like wt_range_walker, until a node is expanded while the ranges
+ * of all nodes remaining on the stack contain at most options_type::cutoff entries in total.
+ * Then, all leaves below these nodes are extracted in a single top-down traversal and
+ * the walker continues on the sorted list of these leaves. Hence, next_right merely
+ * advances in the list, which turns the comparison with other walkers into a merge
+ * of sorted lists. Walkers of frequent subpatterns are not affected, as their subtrees
+ * are pruned by the other walkers before they are extracted.
+ * In contrast to wt_fixed_range_walker, the extracted leaves are stored on the heap.
+ */
+template<typename wt_type,
+         typename t_stack = fixed_stack<std::pair<range_type, wt_node_cache<wt_type>>, wt_dfs_stack_capacity<wt_type>::value>>
+class wt_hybrid_range_walker
+{
+        static_assert(std::is_same<typename index_tag<wt_type>::type, wt_tag>::value,
+                      "First template argument has to be a wavelet tree.");
+
+    private:
+        typedef wt_node_cache<wt_type> node_type;
+        const wt_type&         wt;
+        t_stack                dfs_stack;
+        std::vector<node_type> m_leaves;       // extracted leaves, which lie on top of dfs_stack
+        size_t                 m_leaf_pos = 0; // current position in m_leaves
+        size_t                 m_cutoff;
+        size_t                 m_remaining;    // number of entries in the ranges on dfs_stack
+
+        static size_t range_size(const range_type& r)
+        {
+            return r[1] - r[0] + 1;
+        }
+
+        void push(const range_type& r, const node_type& v)
+        {
+            dfs_stack.emplace_back(r, v);
+            m_remaining += range_size(r);
+        }
+
+        void pop()
+        {
+            m_remaining -= range_size(dfs_stack.back().first);
+            dfs_stack.pop_back();
+        }
+
+        // Appends the leaves below v, whose range is r, to m_leaves in left-to-right order.
+        void extract(const node_type& v, const range_type& r)
+        {
+            if (v.is_leaf) {
+                m_leaves.push_back(v);
+                return;
+            }
+            auto children = wt.expand_with_range(v.node, r);
+            for (size_t c = 0; c < children.size(); ++c) {
+                if (!empty(children[c].second))
+                    extract(node_type(children[c].first, wt), children[c].second);
+            }
+        }
+
+    public:
+        //! Options of the traversal.
+        struct options_type {
+            //! Ranges of at most this size are extracted at once.
+            size_t cutoff = 64;
+        };
+
+        //! Constructor
+        wt_hybrid_range_walker(const wt_type& wt, range_type initial_range, node_type root_node,
+                               const options_type& options = options_type())
+            : wt(wt), m_cutoff(options.cutoff), m_remaining(0)
+        {
+            dfs_stack.reserve(8 * sizeof(typename wt_type::size_type)); // = max. depth
+            push(initial_range, root_node);
+        }
+
+        //! Returns whether the traversal has not yet reached the end of the wavelet tree.
+        inline bool has_more() const
+        {
+            return m_leaf_pos < m_leaves.size() or !dfs_stack.empty();
+        }
+
+        //! Returns the wavelet tree node currently pointed at by the walker.
+        inline const node_type& current_node() const
+        {
+            if (m_leaf_pos < m_leaves.size())
+                return m_leaves[m_leaf_pos];
+            return dfs_stack.back().second;
+        }
+
+        //! Traverse to the next node, discarding any child nodes of the current node.
+        inline void next_right()
+        {
+            if (m_leaf_pos < m_leaves.size())
+                ++m_leaf_pos;
+            else
+                pop();
+        }
+
+        //! Traverse to the first non-empty child node of the current node.
+        /*!
+         * If the remaining ranges contain at most cutoff entries,
+         * the traversal continues on the extracted leaves instead.
+         */
+        inline void next_down()
+        {
+            if (m_remaining <= m_cutoff) {
+                m_leaves.clear();
+                m_leaf_pos = 0;
+                while (!dfs_stack.empty()) { // from left to right
+                    auto top = dfs_stack.back(); pop();
+                    extract(top.second, top.first);
+                }
+                return;
+            }
+            auto top = dfs_stack.back(); pop();
+            auto& node = top.second;
+            auto children = wt.expand_with_range(node.node, top.first);
+            for (size_t c = children.size(); c > 0; --c) { // leftmost child on top
+                if (!empty(children[c-1].second))
+                    push(children[c-1].second, node_type(children[c-1].first, wt));
+            }
         }
 
         //! Traverse to the next leaf. Returns false if there is no more, i.e. the traversal has finished.
@@ -41,6 +41,24 @@
 namespace sdsl
 {
 
+//! Layout of wt_int which concatenates the bitvectors of the nodes level by level.
+/*!
+ * A layout determines where the bitvector of each node starts in the concatenation
+ * of all bitvectors of the tree. Its child_offset returns the offset of the left
+ * (bit=0) or right (bit=1) child of the inner node at the given offset and level,
+ * which has node_size bits, ones of them set, in a tree over n symbols with
+ * max_level levels. Its arrange rearranges the bits of a tree built level by level
+ * into the layout.
+ */
+struct wt_int_level_layout {
+    static uint64_t child_offset(uint64_t offset, uint64_t, uint64_t node_size, uint64_t ones, bool bit,
+                                 uint64_t n, uint64_t) {
+        return offset + n + (bit ? node_size - ones : 0);
+    }
+
+    static void arrange(bit_vector&, uint64_t, uint64_t) { }
+};
+
 //! A wavelet tree class for integer sequences.
 /*!
  *    \par Space complexity
@@ -50,13 +68,16 @@ namespace sdsl
  *  \tparam t_rank        Type of the support structure for rank on pattern `1`.
  *  \tparam t_select      Type of the support structure for select on pattern `1`.
  *  \tparam t_select_zero Type of the support structure for select on pattern `0`.
+ *  \tparam t_layout      Order of the node bitvectors in the concatenation of all bitvectors
+ *                        (e.g. wt_int_level_layout or wt_int_dfs_layout).
  *
  *   @ingroup wt
  */
 template<class t_bitvector   = bit_vector,
          class t_rank        = typename t_bitvector::rank_1_type,
          class t_select      = typename t_bitvector::select_1_type,
-         class t_select_zero = typename t_bitvector::select_0_type>
+         class t_select_zero = typename t_bitvector::select_0_type,
+         class t_layout      = wt_int_level_layout>
 class wt_int
 {
     public:
@@ -114,6 +135,13 @@ class wt_int
             m_path_rank_off = int_vector<64>(max_level+1);
         }
 
+        // Offset of the left (bit=0) or right (bit=1) child of the inner node
+        // at the given offset and level, which contains `ones` set bits.
+        size_type child_offset(size_type offset, size_type level, size_type node_size,
+                               size_type ones, bool bit) const {
+            return t_layout::child_offset(offset, level, node_size, ones, bit, m_size, m_max_level);
+        }
+
         // recursive internal version of the method interval_symbols
         void _interval_symbols(size_type i, size_type j, size_type& k,
                                std::vector<value_type>& cs,
@@ -139,7 +167,7 @@ class wt_int
 
             // goto left child
             if ((j-i)-(ones_before_j-ones_before_i)>0) {
-                size_type new_offset = offset + m_size;
+                size_type new_offset = child_offset(offset, level, node_size, ones_before_end, 0);
                 size_type new_node_size = node_size - ones_before_end;
                 size_type new_i = i - ones_before_i;
                 size_type new_j = j - ones_before_j;
@@ -148,7 +176,7 @@ class wt_int
 
             // goto right child
             if ((ones_before_j-ones_before_i)>0) {
-                size_type new_offset = offset+(node_size - ones_before_end) + m_size;
+                size_type new_offset = child_offset(offset, level, node_size, ones_before_end, 1);
                 size_type new_node_size = ones_before_end;
                 size_type new_i = ones_before_i;
                 size_type new_j = ones_before_j;
@@ -262,6 +290,7 @@ class wt_int
             bit_vector tree;
             load_from_file(tree, tree_out_buf_file_name);
             sdsl::remove(tree_out_buf_file_name);
+            t_layout::arrange(tree, m_size, m_max_level);
             m_tree = bit_vector_type(std::move(tree));
             util::init_support(m_tree_rank, &m_tree);
             util::init_support(m_tree_select0, &m_tree);
@@ -347,15 +376,15 @@ class wt_int
                 size_type ones_before_i   = m_tree_rank(offset + i) - ones_before_o;
                 size_type ones_before_end = m_tree_rank(offset + node_size) - ones_before_o;
                 if (m_tree[offset+i]) { // one at position i => follow right child
-                    offset += (node_size - ones_before_end);
+                    offset = child_offset(offset, k, node_size, ones_before_end, 1);
                     node_size = ones_before_end;
                     i = ones_before_i;
                     res |= 1;
                 } else { // zero at position i => follow left child
+                    offset = child_offset(offset, k, node_size, ones_before_end, 0);
                     node_size = (node_size - ones_before_end);
                     i = (i-ones_before_i);
                 }
-                offset += m_size;
             }
             return res;
         };
@@ -383,14 +412,14 @@ class wt_int
                 size_type ones_before_i   = m_tree_rank(offset + i) - ones_before_o;
                 size_type ones_before_end = m_tree_rank(offset + node_size) - ones_before_o;
                 if (c & mask) { // search for a one at this level
-                    offset += (node_size - ones_before_end);
+                    offset = child_offset(offset, k, node_size, ones_before_end, 1);
                     node_size = ones_before_end;
                     i = ones_before_i;
                 } else { // search for a zero at this level
+                    offset = child_offset(offset, k, node_size, ones_before_end, 0);
                     node_size = (node_size - ones_before_end);
                     i = (i-ones_before_i);
                 }
-                offset += m_size;
                 mask >>= 1;
             }
             return i;
@@ -417,15 +446,15 @@ class wt_int
                 size_type ones_before_end = m_tree_rank(offset + node_size) - ones_before_o;
                 c<<=1;
                 if (m_tree[offset+i]) { // go to the right child
-                    offset += (node_size - ones_before_end);
+                    offset = child_offset(offset, k, node_size, ones_before_end, 1);
                     node_size = ones_before_end;
                     i = ones_before_i;
                     c|=1;
                 } else { // go to the left child
+                    offset = child_offset(offset, k, node_size, ones_before_end, 0);
                     node_size = (node_size - ones_before_end);
                     i = (i-ones_before_i);
                 }
-                offset += m_size;
             }
             return std::make_pair(i,c);
         }
@@ -452,12 +481,12 @@ class wt_int
                 m_path_rank_off[k] = ones_before_o;
                 size_type ones_before_end = m_tree_rank(offset + node_size) - ones_before_o;
                 if (c & mask) { // search for a one at this level
-                    offset += (node_size - ones_before_end);
+                    offset = child_offset(offset, k, node_size, ones_before_end, 1);
                     node_size = ones_before_end;
                 } else { // search for a zero at this level
+                    offset = child_offset(offset, k, node_size, ones_before_end, 0);
                     node_size = (node_size - ones_before_end);
                 }
-                offset += m_size;
                 m_path_off[k+1] = offset;
                 mask >>= 1;
             }
@@ -553,18 +582,18 @@ class wt_int
                 size_type ones_before_j   = m_tree_rank(offset + j) - ones_before_o;
                 size_type ones_before_end = m_tree_rank(offset + node_size) - ones_before_o;
                 if (c & mask) { // search for a one at this level
-                    offset += (node_size - ones_before_end);
+                    offset = child_offset(offset, k, node_size, ones_before_end, 1);
                     node_size = ones_before_end;
                     smaller += j-i-ones_before_j+ones_before_i;
                     i = ones_before_i;
                     j = ones_before_j;
                 } else { // search for a zero at this level
+                    offset = child_offset(offset, k, node_size, ones_before_end, 0);
                     node_size -= ones_before_end;
                     greater += ones_before_j-ones_before_i;
                     i -= ones_before_i;
                     j -= ones_before_j;
                 }
-                offset += m_size;
                 mask >>= 1;
             }
             return t_ret_type {i, smaller, greater};
@@ -595,15 +624,15 @@ class wt_int
                 size_type ones_before_i   = m_tree_rank(offset + i) - ones_before_o;
                 size_type ones_before_end = m_tree_rank(offset + node_size) - ones_before_o;
                 if (c & mask) { // search for a one at this level
-                    offset   += (node_size - ones_before_end);
+                    offset    = child_offset(offset, k, node_size, ones_before_end, 1);
                     node_size = ones_before_end;
                     result   += i - ones_before_i;
                     i         = ones_before_i;
                 } else { // search for a zero at this level
+                    offset = child_offset(offset, k, node_size, ones_before_end, 0);
                     node_size = (node_size - ones_before_end);
                     i        -= ones_before_i;
                 }
-                offset += m_size;
                 mask >>= 1;
             }
             return t_ret_type {i, result};
@@ -677,19 +706,20 @@ class wt_int
             size_type zeros_before_lb  = offset + lb - ones_before_lb;
             size_type zeros_before_rb  = offset + rb + 1 - ones_before_rb;
             size_type zeros_before_end = offset + node_size - ones_before_end;
+            size_type ones             = ones_before_end - ones_before_o;
             if (vlb < mid and mid) {
                 size_type nlb    = zeros_before_lb - zeros_before_o;
                 size_type nrb    = zeros_before_rb - zeros_before_o;
-                offsets[level+1] = offset + m_size;
+                offsets[level+1] = child_offset(offset, level, node_size, ones, 0);
                 if (nrb)
                     _range_search_2d(nlb, nrb-1, vlb, std::min(vrb,mid-1), level+1, ilb, zeros_before_end - zeros_before_o, offsets, ones_before_os, path<<1, point_vec, report, cnt_answers);
             }
             if (vrb >= mid) {
                 size_type nlb     = ones_before_lb - ones_before_o;
                 size_type nrb     = ones_before_rb - ones_before_o;
-                offsets[level+1]  = offset + m_size + (zeros_before_end - zeros_before_o);
+                offsets[level+1]  = child_offset(offset, level, node_size, ones, 1);
                 if (nrb)
-                    _range_search_2d(nlb, nrb-1, std::max(mid, vlb), vrb, level+1, mid, ones_before_end - ones_before_o, offsets, ones_before_os, (path<<1)+1 , point_vec, report, cnt_answers);
+                    _range_search_2d(nlb, nrb-1, std::max(mid, vlb), vrb, level+1, mid, ones, offsets, ones_before_os, (path<<1)+1 , point_vec, report, cnt_answers);
             }
         }
 
@@ -732,6 +762,10 @@ class wt_int
         }
 
         //! Represents a node in the wavelet tree
+        /*!
+         * Empty nodes and, depending on the layout, leaves may share their offset
+         * with other nodes. Nodes are therefore identified by level and symbol.
+         */
         struct node_type {
             size_type  offset   = 0;
             size_type  size     = 0;
@@ -757,17 +791,17 @@ class wt_int
 
             // Comparator operator
             bool operator==(const node_type& v) const {
-                return offset == v.offset;
+                return level == v.level and sym == v.sym;
             }
 
             // Smaller operator
             bool operator<(const node_type& v) const {
-                return offset < v.offset;
+                return level < v.level or (level == v.level and sym < v.sym);
             }
 
             // Greater operator
             bool operator>(const node_type& v) const {
-                return offset > v.offset;
+                return v < *this;
             }
         };
 
@@ -838,12 +872,12 @@ class wt_int
             size_type offset_rank = m_tree_rank(v.offset);
             size_type ones        = m_tree_rank(v.offset + v.size) - offset_rank;
 
-            v_left.offset = v.offset + m_size;
+            v_left.offset = child_offset(v.offset, v.level, v.size, ones, 0);
             v_left.size   = v.size - ones;
             v_left.level  = v.level + 1;
             v_left.sym    = v.sym<<1;
 
-            v.offset = v.offset + m_size + v_left.size;
+            v.offset = child_offset(v.offset, v.level, v.size, ones, 1);
             v.size   = ones;
             v.level  = v.level + 1;
             v.sym    = (v.sym<<1)|1;
@@ -926,6 +960,36 @@ class wt_int
             };
         }
 
+        //! Returns the two child nodes of an inner node and the mapping of a range to them
+        /*! \param v An inner node of an wavelet tree.
+         *  \param r A ranges [s,e], such that [s,e] is
+         *           contained in v=[v_s,v_e].
+         *  \return An array of (node, range) pairs (left child, right child).
+         *          Yields the same as expand(v) and expand(v, r),
+         *          but each rank is calculated only once.
+         *  \pre !is_leaf(v) and s>=v_s and e<=v_e
+         */
+        std::array<std::pair<node_type, range_type>, 2>
+        expand_with_range(const node_type& v, const range_type& r) const {
+            auto v_sp_rank  = m_tree_rank(v.offset);
+            auto v_ep_rank  = m_tree_rank(v.offset + v.size);
+            auto sp_rank    = r[0] == 0 ? v_sp_rank : m_tree_rank(v.offset + r[0]);
+            auto ep_rank    = r[1] + 1 == v.size ? v_ep_rank : m_tree_rank(v.offset + r[1] + 1);
+            auto ones       = v_ep_rank - v_sp_rank;
+            auto right_size = ep_rank - sp_rank;
+            auto left_size  = (r[1]-r[0]+1)-right_size;
+
+            auto right_sp = sp_rank - v_sp_rank;
+            auto left_sp  = r[0] - right_sp;
+
+            return {{{node_type(child_offset(v.offset, v.level, v.size, ones, 0), v.size - ones, v.level + 1, v.sym<<1),
+                      {{left_sp, left_sp + left_size - 1}}},
+                    {node_type(child_offset(v.offset, v.level, v.size, ones, 1), ones, v.level + 1, (v.sym<<1)|1),
+                     {{right_sp, right_sp + right_size - 1}}}
+                }
+            };
+        }
+
         //! return the path to the leaf for a given symbol
         std::pair<uint64_t,uint64_t> path(value_type c) const {
             return {m_max_level,c};
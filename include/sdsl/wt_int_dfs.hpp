@@ -0,0 +1,116 @@
+/* sdsl - succinct data structures library
+    Copyright (C) 2016 Simon Gog
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+/*! \file wt_int_dfs.hpp
+    \brief wt_int_dfs.hpp contains a layout of wt_int which stores the top
+           levels level-wise and the subtrees below in depth-first order.
+*/
+#ifndef INCLUDED_SDSL_INT_DFS_WAVELET_TREE
+#define INCLUDED_SDSL_INT_DFS_WAVELET_TREE
+
+#include "int_vector.hpp"
+#include "rank_support_v.hpp"
+#include "wt_int.hpp"
+#include <algorithm>
+#include <utility>
+
+//! Namespace for the succinct data structure library.
+namespace sdsl
+{
+
+//! Layout of wt_int with node-local bits (see wt_int_level_layout for the interface).
+/*!
+ *  \tparam t_top_levels  Number of levels which are stored level-wise.
+ *
+ *  The bitvectors of the nodes on the first t_top_levels levels are concatenated
+ *  level by level as in wt_int_level_layout. Each subtree rooted at level t_top_levels
+ *  is stored contiguously in depth-first order (node, left subtree, right subtree).
+ *  Hence, the left child of a node in such a subtree starts directly behind the node
+ *  and the bits accessed while descending stay close to each other, which saves cache
+ *  misses in top-down traversals like the gapped pattern matching of vlg_index.
+ *  During construction, the level-wise tree and its rearranged copy coexist, so
+ *  \f$ 2n\log|\Sigma| + O(1)\f$ bits are required.
+ */
+template<uint32_t t_top_levels = 8>
+struct wt_int_dfs_layout {
+    static uint64_t child_offset(uint64_t offset, uint64_t level, uint64_t node_size, uint64_t ones, bool bit,
+                                 uint64_t n, uint64_t max_level) {
+        uint64_t top_levels = std::min((uint64_t)t_top_levels, max_level);
+        uint64_t left_size  = bit ? node_size - ones : 0;
+        if (level + 1 < top_levels) { // level-wise
+            return offset + n + left_size;
+        } else if (level + 1 == top_levels) { // root of a depth-first subtree
+            uint64_t start = offset - level*n + left_size;
+            return top_levels*n + start*(max_level - top_levels);
+        } else { // depth-first: skip the node and the left subtree
+            return offset + node_size + left_size*(max_level - level - 1);
+        }
+    }
+
+    static void arrange(bit_vector& tree, uint64_t n, uint64_t max_level) {
+        uint64_t top_levels = std::min((uint64_t)t_top_levels, max_level);
+        if (top_levels == max_level)
+            return;
+        const bit_vector level_wise(std::move(tree));
+        rank_support_v<> rank(&level_wise);
+        tree = bit_vector(n*max_level, 0);
+        // copy the level-wise part and rearrange the subtrees below in depth-first order
+        uint64_t top_bits = top_levels*n;
+        copy_bits(level_wise, 0, top_bits, tree, 0);
+        uint64_t pos = top_bits;
+        copy_level(level_wise, rank, 0, n, 0, top_levels, n, max_level, tree, pos);
+    }
+
+private:
+    static void copy_bits(const bit_vector& from, uint64_t offset, uint64_t size, bit_vector& to, uint64_t pos) {
+        for (uint64_t i = 0; i < size; i += 64) {
+            uint8_t len = std::min((uint64_t)64, size - i);
+            to.set_int(pos + i, from.get_int(offset + i, len), len);
+        }
+    }
+
+    // Copies the subtree of the level-wise tree rooted at the node at offset on level
+    // (if level is top_levels) or the subtrees below it on level top_levels in depth-first order to tree[pos..].
+    static void copy_level(const bit_vector& level_wise, const rank_support_v<>& rank, uint64_t offset,
+                           uint64_t node_size, uint64_t level, uint64_t top_levels, uint64_t n,
+                           uint64_t max_level, bit_vector& tree, uint64_t& pos) {
+        if (node_size == 0 or level == max_level)
+            return;
+        if (level >= top_levels) {
+            copy_bits(level_wise, offset, node_size, tree, pos);
+            pos += node_size;
+        }
+        uint64_t ones = rank(offset + node_size) - rank(offset);
+        copy_level(level_wise, rank, offset + n, node_size - ones, level + 1, top_levels, n, max_level, tree, pos);
+        copy_level(level_wise, rank, offset + n + node_size - ones, ones, level + 1, top_levels, n, max_level, tree, pos);
+    }
+};
+
+//! A wavelet tree class for integer sequences with a node-local bit layout.
+/*!
+ *  The tree is a wt_int whose bitvectors are arranged by wt_int_dfs_layout<t_top_levels>.
+ *
+ *   @ingroup wt
+ */
+template<class t_bitvector   = bit_vector,
+         class t_rank        = typename t_bitvector::rank_1_type,
+         class t_select      = typename t_bitvector::select_1_type,
+         class t_select_zero = typename t_bitvector::select_0_type,
+         uint32_t t_top_levels = 8>
+using wt_int_dfs = wt_int<t_bitvector, t_rank, t_select, t_select_zero, wt_int_dfs_layout<t_top_levels>>;
+
+}// end namespace sdsl
+#endif
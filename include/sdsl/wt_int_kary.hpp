@@ -0,0 +1,730 @@
+/* sdsl - succinct data structures library
+    Copyright (C) 2016 Simon Gog
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+/*! \file wt_int_kary.hpp
+    \brief wt_int_kary.hpp contains a multi-ary wavelet tree for integer sequences.
+*/
+#ifndef INCLUDED_SDSL_INT_KARY_WAVELET_TREE
+#define INCLUDED_SDSL_INT_KARY_WAVELET_TREE
+
+#include "sdsl_concepts.hpp"
+#include "int_vector.hpp"
+#include "wt_helper.hpp"
+#include "util.hpp"
+#include <algorithm> // for std::swap
+#include <array>
+#include <stdexcept>
+#include <utility>
+
+//! Namespace for the succinct data structure library.
+namespace sdsl
+{
+
+//! A sequence of t_bits-bit digits supporting rank and select for each digit value.
+/*!
+ * \tparam t_bits Number of bits per digit.
+ *
+ * The digits are split into blocks of 256. A block stores t_bits bit planes
+ * of four words each (plane j holds the j-th bit of each digit), preceded by
+ * 16-bit counters of each digit value relative to the superblock (8 blocks).
+ * The occurrences of a digit in a word are counted by combining the planes with
+ * AND and a single popcount, so 64 digits are processed at once.
+ */
+template<uint8_t t_bits>
+class _kary_sequence
+{
+    public:
+        typedef int_vector<>::size_type size_type;
+        typedef uint64_t                value_type;
+        enum {sigma = 1U << t_bits};
+        typedef std::array<size_type, sigma> counts_type;
+
+    private:
+        static const size_type block_size       = 256;
+        static const size_type superblock_size  = 2048;
+        static const size_type words_per_plane  = block_size / 64;
+        static const size_type header_words     = (sigma*16+63) / 64;
+        static const size_type block_words      = header_words + t_bits*words_per_plane;
+
+        size_type      m_size = 0;
+        int_vector<64> m_data;  // blocks consisting of header and bit planes
+        int_vector<64> m_super; // number of occurrences of each digit before a superblock
+
+        const uint64_t* block(size_type i) const {
+            return m_data.data() + (i/block_size)*block_words;
+        }
+
+        // Bit mask of the digits equal to c in word w of a block.
+        static uint64_t match(const uint64_t* blk, size_type w, value_type c) {
+            uint64_t mask = bits::all_set;
+            for (uint8_t j = 0; j < t_bits; ++j) {
+                uint64_t plane = blk[header_words + j*words_per_plane + w];
+                mask &= ((c >> j) & 1) ? plane : ~plane;
+            }
+            return mask;
+        }
+
+        size_type block_rank(const uint64_t* blk, size_type i, value_type c) const {
+            return m_super[(i/superblock_size)*sigma + c] + ((blk[c/4] >> ((c%4)*16)) & 0xFFFFULL);
+        }
+
+    public:
+        _kary_sequence() = default;
+
+        //! Constructor
+        /*! \param n     Number of digits.
+         *  \param digit Function returning the i-th digit.
+         */
+        template<class t_digit>
+        _kary_sequence(size_type n, t_digit digit) : m_size(n) {
+            size_type blocks = n/block_size + 1;
+            m_data  = int_vector<64>(blocks*block_words, 0);
+            m_super = int_vector<64>((n/superblock_size + 1)*sigma, 0);
+            counts_type total, in_super;
+            total.fill(0);
+            in_super.fill(0);
+            for (size_type b = 0; b < blocks; ++b) {
+                size_type begin = b*block_size;
+                if (begin % superblock_size == 0) {
+                    for (value_type c = 0; c < sigma; ++c)
+                        m_super[(begin/superblock_size)*sigma + c] = total[c];
+                    in_super.fill(0);
+                }
+                uint64_t* blk = m_data.data() + b*block_words;
+                for (value_type c = 0; c < sigma; ++c)
+                    blk[c/4] |= in_super[c] << ((c%4)*16);
+                for (size_type i = begin; i < std::min(n, begin + block_size); ++i) {
+                    value_type d = digit(i);
+                    size_type  w = (i % block_size) / 64;
+                    for (uint8_t j = 0; j < t_bits; ++j)
+                        blk[header_words + j*words_per_plane + w] |= ((d >> j) & 1ULL) << (i % 64);
+                    ++total[d];
+                    ++in_super[d];
+                }
+            }
+        }
+
+        //! Returns the number of digits.
+        size_type size() const {
+            return m_size;
+        }
+
+        //! Returns the i-th digit.
+        value_type operator[](size_type i) const {
+            const uint64_t* blk = block(i);
+            size_type w = (i % block_size) / 64;
+            value_type d = 0;
+            for (uint8_t j = 0; j < t_bits; ++j)
+                d |= ((blk[header_words + j*words_per_plane + w] >> (i % 64)) & 1ULL) << j;
+            return d;
+        }
+
+        //! Returns the number of occurrences of digit c in [0..i-1].
+        size_type rank(size_type i, value_type c) const {
+            const uint64_t* blk = block(i);
+            size_type res = block_rank(blk, i, c);
+            size_type w_end = (i % block_size) / 64;
+            for (size_type w = 0; w < w_end; ++w)
+                res += bits::cnt(match(blk, w, c));
+            if (i % 64)
+                res += bits::cnt(match(blk, w_end, c) & bits::lo_set[i % 64]);
+            return res;
+        }
+
+        //! Calculates the number of occurrences of each digit in [0..i-1].
+        void rank_all(size_type i, counts_type& res) const {
+            const uint64_t* blk = block(i);
+            for (value_type c = 0; c < sigma; ++c)
+                res[c] = block_rank(blk, i, c);
+            size_type w_end = (i % block_size) / 64;
+            for (size_type w = 0; w <= w_end; ++w) {
+                uint64_t mask = w < w_end ? bits::all_set : bits::lo_set[i % 64];
+                if (!mask)
+                    break;
+                // load the planes of the word once and derive the matches of all digits
+                uint64_t planes[t_bits];
+                for (uint8_t j = 0; j < t_bits; ++j)
+                    planes[j] = blk[header_words + j*words_per_plane + w];
+                for (value_type c = 0; c < sigma; ++c) {
+                    uint64_t m = mask;
+                    for (uint8_t j = 0; j < t_bits; ++j)
+                        m &= ((c >> j) & 1) ? planes[j] : ~planes[j];
+                    res[c] += bits::cnt(m);
+                }
+            }
+        }
+
+        //! Returns the position of the j-th occurrence of digit c.
+        /*! \pre 1 <= j <= rank(size(), c)
+         */
+        size_type select(size_type j, value_type c) const {
+            // last superblock containing less than j occurrences before it
+            size_type lo = 0, hi = m_super.size()/sigma - 1;
+            while (lo < hi) {
+                size_type mid = (lo + hi + 1) / 2;
+                if (m_super[mid*sigma + c] < j)
+                    lo = mid;
+                else
+                    hi = mid - 1;
+            }
+            size_type b = lo*(superblock_size/block_size);
+            size_type b_end = std::min(m_data.size()/block_words, b + superblock_size/block_size);
+            while (b + 1 < b_end and block_rank(m_data.data() + (b+1)*block_words, (b+1)*block_size, c) < j)
+                ++b;
+            const uint64_t* blk = m_data.data() + b*block_words;
+            j -= block_rank(blk, b*block_size, c);
+            for (size_type w = 0; w < words_per_plane; ++w) {
+                uint64_t mask = match(blk, w, c);
+                size_type cnt = bits::cnt(mask);
+                if (cnt >= j)
+                    return b*block_size + w*64 + bits::sel(mask, j);
+                j -= cnt;
+            }
+            return m_size;
+        }
+
+        //! Swap operator
+        void swap(_kary_sequence& s) {
+            if (this != &s) {
+                std::swap(m_size, s.m_size);
+                m_data.swap(s.m_data);
+                m_super.swap(s.m_super);
+            }
+        }
+
+        //! Serializes the data structure into the given ostream
+        size_type serialize(std::ostream& out, structure_tree_node* v=nullptr, std::string name="")const {
+            structure_tree_node* child = structure_tree::add_child(v, name, util::class_name(*this));
+            size_type written_bytes = 0;
+            written_bytes += write_member(m_size, out, child, "size");
+            written_bytes += m_data.serialize(out, child, "data");
+            written_bytes += m_super.serialize(out, child, "super");
+            structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        //! Loads the data structure from the given istream.
+        void load(std::istream& in) {
+            read_member(m_size, in);
+            m_data.load(in);
+            m_super.load(in);
+        }
+};
+
+//! A multi-ary wavelet tree class for integer sequences.
+/*!
+ *    \par Space complexity
+ *        \f$\Order{n\log|\Sigma|}\f$ bits, where \f$n\f$ is the size of the vector the wavelet tree was build for.
+ *
+ *  \tparam t_bits Number of symbol bits per level, i.e., each inner node has 2^t_bits children.
+ *
+ *  The tree has the same level-wise layout as wt_int, but each level stores
+ *  a digit of t_bits bits per symbol. So a 4-ary (t_bits=2) or 8-ary (t_bits=3)
+ *  tree has only a half or a third of the levels of the binary tree, which shortens
+ *  each root-to-leaf descent accordingly.
+ *  Nodes are expanded into all 2^t_bits children at once (see expand and expand_with_range).
+ *  In contrast to the binary wavelet trees, the nodes do not expose bitvectors.
+ *
+ *   @ingroup wt
+ */
+template<uint8_t t_bits = 2>
+class wt_int_kary
+{
+        static_assert(t_bits >= 1 and t_bits <= 4, "Number of bits per level has to be in [1..4].");
+
+    public:
+
+        typedef int_vector<>::size_type                   size_type;
+        typedef int_vector<>::value_type                  value_type;
+        typedef int_vector<>::difference_type             difference_type;
+        typedef random_access_const_iterator<wt_int_kary> const_iterator;
+        typedef const_iterator                            iterator;
+        typedef _kary_sequence<t_bits>                    sequence_type;
+        typedef wt_tag                                    index_category;
+        typedef int_alphabet_tag                          alphabet_category;
+        enum 	{lex_ordered=1};
+        enum    {traversable=true};
+        enum    {arity=1U << t_bits};
+
+    protected:
+        typedef typename sequence_type::counts_type counts_type;
+
+        size_type              m_size  = 0;
+        size_type              m_sigma = 0;    //<- \f$ |\Sigma| \f$
+        sequence_type          m_tree;         // digits of all levels
+        uint32_t               m_max_level = 0;
+        mutable int_vector<64> m_path_off;     // array keeps track of path offset in select-like methods
+        mutable int_vector<64> m_path_rank_off;// array keeps track of rank values for the offsets
+
+        void copy(const wt_int_kary& wt) {
+            m_size          = wt.m_size;
+            m_sigma         = wt.m_sigma;
+            m_tree          = wt.m_tree;
+            m_max_level     = wt.m_max_level;
+            m_path_off      = wt.m_path_off;
+            m_path_rank_off = wt.m_path_rank_off;
+        }
+
+    private:
+
+        void init_buffers(uint32_t max_level) {
+            m_path_off = int_vector<64>(max_level+1);
+            m_path_rank_off = int_vector<64>(max_level+1);
+        }
+
+        // Shifts x to the right by s bits; s may exceed the word size.
+        static value_type shift_right(value_type x, size_type s) {
+            return s < 64 ? x >> s : 0;
+        }
+
+        // Returns the digit of symbol c on the given level.
+        value_type digit(value_type c, size_type level) const {
+            return shift_right(c, t_bits*(m_max_level-level-1)) & (arity-1);
+        }
+
+        // Calculates the occurrences of each digit before and in node [offset..offset+node_size-1].
+        void node_counts(size_type offset, size_type node_size, counts_type& before, counts_type& cnt) const {
+            m_tree.rank_all(offset, before);
+            m_tree.rank_all(offset + node_size, cnt);
+            for (size_type c = 0; c < arity; ++c)
+                cnt[c] -= before[c];
+        }
+
+        // Returns the offset of the child of the node at offset which is reached by digit d.
+        size_type child_offset(size_type offset, const counts_type& cnt, value_type d) const {
+            size_type res = offset + m_size;
+            for (value_type c = 0; c < d; ++c)
+                res += cnt[c];
+            return res;
+        }
+
+    public:
+
+        const size_type&     sigma = m_sigma;         //!< Effective alphabet size of the wavelet tree.
+        const sequence_type& tree  = m_tree;          //!< A concatenation of the digit sequences of all levels.
+        const uint32_t&      max_level = m_max_level; //!< Number of levels of the wavelet tree.
+
+        //! Default constructor
+        wt_int_kary() {
+            init_buffers(m_max_level);
+        };
+
+        //! Constructor
+        /*! \param buf         File buffer of the int_vector for which the wt_int_kary should be build.
+         *  \param size        Size of the prefix of v, which should be indexed.
+         *  \param max_level   Number of levels of the wavelet tree. If set to 0, determined automatically.
+         *    \par Time complexity
+         *        \f$ \Order{n\log|\Sigma|}\f$, where \f$n=size\f$
+         *    \par Space complexity
+         *        \f$ 2n\log|\Sigma| + O(1)\f$ bits, where \f$n=size\f$.
+         */
+        template<uint8_t int_width>
+        wt_int_kary(int_vector_buffer<int_width>& buf, size_type size,
+                    uint32_t max_level=0) : m_size(size) {
+            init_buffers(m_max_level);
+            if (0 == m_size)
+                return;
+            size_type n = buf.size();  // set n
+            if (n < m_size) {
+                throw std::logic_error("n="+util::to_string(n)+" < "+util::to_string(m_size)+"=m_size");
+                return;
+            }
+            m_sigma = 0;
+            int_vector<int_width> rac(m_size, 0, buf.width());
+            value_type x = 1;  // variable for the biggest value in rac
+            for (size_type i=0; i < m_size; ++i) {
+                if (buf[i] > x)
+                    x = buf[i];
+                rac[i] = buf[i];
+            }
+            if (max_level == 0) {
+                m_max_level = (bits::hi(x)+t_bits) / t_bits; // levels to represent all values in [0..x]
+            } else {
+                m_max_level = max_level;
+            }
+            init_buffers(m_max_level);
+
+            // The nodes of a level are the runs of equal prefixes. Their digits are
+            // written to the level and the values are partitioned by the digit.
+            int_vector<> digits(m_max_level*m_size, 0, t_bits);
+            int_vector<int_width> part(m_size, 0, buf.width());
+            for (uint32_t k=0; k < m_max_level; ++k) {
+                size_type shift = t_bits*(m_max_level-k-1);
+                size_type start = 0;
+                while (start < m_size) {
+                    value_type prefix = shift_right(rac[start], shift + t_bits);
+                    size_type end = start;
+                    counts_type cnt;
+                    cnt.fill(0);
+                    while (end < m_size and shift_right(rac[end], shift + t_bits) == prefix) {
+                        value_type d = shift_right(rac[end], shift) & (arity-1);
+                        digits[k*m_size + end] = d;
+                        ++cnt[d];
+                        ++end;
+                    }
+                    if (k+1 < m_max_level) { // inner node
+                        counts_type pos;
+                        pos[0] = start;
+                        for (size_type c = 1; c < arity; ++c)
+                            pos[c] = pos[c-1] + cnt[c-1];
+                        for (size_type i = start; i < end; ++i)
+                            part[pos[shift_right(rac[i], shift) & (arity-1)]++] = rac[i];
+                    } else { // leaf nodes
+                        for (size_type c = 0; c < arity; ++c)
+                            m_sigma += cnt[c] > 0;
+                    }
+                    start = end;
+                }
+                if (k+1 < m_max_level)
+                    rac.swap(part);
+            }
+            util::clear(rac);
+            util::clear(part);
+            m_tree = sequence_type(digits.size(), [&digits](size_type i) {
+                return digits[i];
+            });
+        }
+
+        //! Copy constructor
+        wt_int_kary(const wt_int_kary& wt) {
+            copy(wt);
+        }
+
+        //! Copy constructor
+        wt_int_kary(wt_int_kary&& wt) {
+            *this = std::move(wt);
+        }
+
+        //! Assignment operator
+        wt_int_kary& operator=(const wt_int_kary& wt) {
+            if (this != &wt) {
+                copy(wt);
+            }
+            return *this;
+        }
+
+        //! Assignment move operator
+        wt_int_kary& operator=(wt_int_kary&& wt) {
+            if (this != &wt) {
+                m_size          = wt.m_size;
+                m_sigma         = wt.m_sigma;
+                m_tree          = std::move(wt.m_tree);
+                m_max_level     = std::move(wt.m_max_level);
+                m_path_off      = std::move(wt.m_path_off);
+                m_path_rank_off = std::move(wt.m_path_rank_off);
+            }
+            return *this;
+        }
+
+        //! Swap operator
+        void swap(wt_int_kary& wt) {
+            if (this != &wt) {
+                std::swap(m_size, wt.m_size);
+                std::swap(m_sigma,  wt.m_sigma);
+                m_tree.swap(wt.m_tree);
+                std::swap(m_max_level,  wt.m_max_level);
+                m_path_off.swap(wt.m_path_off);
+                m_path_rank_off.swap(wt.m_path_rank_off);
+            }
+        }
+
+        //! Returns the size of the original vector.
+        size_type size()const {
+            return m_size;
+        }
+
+        //! Returns whether the wavelet tree contains no data.
+        bool empty()const {
+            return m_size == 0;
+        }
+
+        //! Recovers the i-th symbol of the original vector.
+        /*! \param i The index of the symbol in the original vector.
+         *  \returns The i-th symbol of the original vector.
+         *  \par Precondition
+         *       \f$ i < size() \f$
+         */
+        value_type operator[](size_type i)const {
+            return inverse_select(i).second;
+        };
+
+        //! Calculates how many symbols c are in the prefix [0..i-1] of the supported vector.
+        /*!
+         *  \param i The exclusive index of the prefix range [0..i-1], so \f$i\in[0..size()]\f$.
+         *  \param c The symbol to count the occurrences in the prefix.
+         *    \returns The number of occurrences of symbol c in the prefix [0..i-1] of the supported vector.
+         *  \par Time complexity
+         *       \f$ \Order{\log |\Sigma| / t\_bits} \f$
+         *  \par Precondition
+         *       \f$ i \leq size() \f$
+         */
+        size_type rank(size_type i, value_type c)const {
+            assert(i <= size());
+            if (shift_right(c, t_bits*m_max_level) > 0) { // c is greater than any symbol in wt
+                return 0;
+            }
+            size_type offset = 0;
+            size_type node_size = m_size;
+            counts_type before, cnt;
+            for (uint32_t k=0; k < m_max_level and i; ++k) {
+                value_type d = digit(c, k);
+                node_counts(offset, node_size, before, cnt);
+                i = m_tree.rank(offset + i, d) - before[d];
+                offset = child_offset(offset, cnt, d);
+                node_size = cnt[d];
+            }
+            return i;
+        };
+
+        //! Calculates how many occurrences of symbol wt[i] are in the prefix [0..i-1] of the original sequence.
+        /*!
+         *  \param i The index of the symbol.
+         *  \return  Pair (rank(wt[i],i),wt[i])
+         *  \par Precondition
+         *       \f$ i < size() \f$
+         */
+        std::pair<size_type, value_type>
+        inverse_select(size_type i)const {
+            assert(i < size());
+            value_type c = 0;
+            size_type node_size = m_size, offset = 0;
+            counts_type before, cnt;
+            for (uint32_t k=0; k < m_max_level; ++k) {
+                value_type d = m_tree[offset + i];
+                node_counts(offset, node_size, before, cnt);
+                i = m_tree.rank(offset + i, d) - before[d];
+                offset = child_offset(offset, cnt, d);
+                node_size = cnt[d];
+                c = (c << t_bits) | d;
+            }
+            return std::make_pair(i, c);
+        }
+
+        //! Calculates the i-th occurrence of the symbol c in the supported vector.
+        /*!
+         *  \param i The i-th occurrence.
+         *  \param c The symbol c.
+         *  \par Time complexity
+         *       \f$ \Order{\log |\Sigma| / t\_bits} \f$
+         *  \par Precondition
+         *       \f$ 1 \leq i \leq rank(size(), c) \f$
+         */
+        size_type select(size_type i, value_type c)const {
+            assert(1 <= i and i <= rank(size(), c));
+            size_type offset = 0;
+            size_type node_size = m_size;
+            counts_type before, cnt;
+            for (uint32_t k=0; k < m_max_level and node_size; ++k) {
+                value_type d = digit(c, k);
+                node_counts(offset, node_size, before, cnt);
+                m_path_off[k] = offset;
+                m_path_rank_off[k] = before[d];
+                offset = child_offset(offset, cnt, d);
+                node_size = cnt[d];
+            }
+            if (0ULL == node_size or node_size < i or shift_right(c, t_bits*m_max_level) > 0) {
+                throw std::logic_error("select("+util::to_string(i)+","+util::to_string(c)+"): c does not occur i times in the WT");
+                return m_size;
+            }
+            for (uint32_t k=m_max_level; k>0; --k) {
+                i = m_tree.select(m_path_rank_off[k-1] + i, digit(c, k-1)) - m_path_off[k-1] + 1;
+            }
+            return i-1;
+        };
+
+        //! Returns a const_iterator to the first element.
+        const_iterator begin()const {
+            return const_iterator(this, 0);
+        }
+
+        //! Returns a const_iterator to the element after the last element.
+        const_iterator end()const {
+            return const_iterator(this, size());
+        }
+
+        //! Serializes the data structure into the given ostream
+        size_type serialize(std::ostream& out, structure_tree_node* v=nullptr, std::string name="")const {
+            structure_tree_node* child = structure_tree::add_child(v, name, util::class_name(*this));
+            size_type written_bytes = 0;
+            written_bytes += write_member(m_size, out, child, "size");
+            written_bytes += write_member(m_sigma, out, child, "sigma");
+            written_bytes += m_tree.serialize(out, child, "tree");
+            written_bytes += write_member(m_max_level, out, child, "max_level");
+            structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        //! Loads the data structure from the given istream.
+        void load(std::istream& in) {
+            read_member(m_size, in);
+            read_member(m_sigma, in);
+            m_tree.load(in);
+            read_member(m_max_level, in);
+            init_buffers(m_max_level);
+        }
+
+        //! Represents a node in the wavelet tree
+        struct node_type {
+            size_type  offset   = 0;
+            size_type  size     = 0;
+            size_type  level    = 0;
+            value_type sym      = 0;
+
+            // Default constructor
+            node_type(size_type o=0, size_type sz=0, size_type l=0,
+                      value_type sy=0) :
+                offset(o), size(sz), level(l), sym(sy) {}
+
+            // Copy constructor
+            node_type(const node_type&) = default;
+
+            // Move copy constructor
+            node_type(node_type&&) = default;
+
+            // Assignment operator
+            node_type& operator=(const node_type&) = default;
+
+            // Move assignment operator
+            node_type& operator=(node_type&&) = default;
+
+            // Comparator operator
+            bool operator==(const node_type& v) const {
+                return level == v.level and sym == v.sym;
+            }
+
+            // Smaller operator
+            bool operator<(const node_type& v) const {
+                return level < v.level or (level == v.level and sym < v.sym);
+            }
+
+            // Greater operator
+            bool operator>(const node_type& v) const {
+                return v < *this;
+            }
+        };
+
+        //! Checks if the node is a leaf node
+        bool is_leaf(const node_type& v) const {
+            return v.level == m_max_level;
+        }
+
+        //! Returns the symbol of leaf node v
+        value_type sym(const node_type& v) const {
+            return v.sym;
+        }
+
+        //! Indicates if node v is empty
+        bool empty(const node_type& v) const {
+            return v.size == (size_type)0;
+        }
+
+        //! Return the size of node v
+        auto size(const node_type& v) const -> decltype(v.size) {
+            return v.size;
+        }
+
+        //! Return the root node
+        node_type root() const {
+            return node_type(0, m_size, 0, 0);
+        }
+
+        //! Returns the child nodes of an inner node
+        /*! \param v An inner node of a wavelet tree.
+         *  \return Return an array of the arity child nodes, ordered by symbol.
+         *  \pre !is_leaf(v)
+         */
+        std::array<node_type, arity>
+        expand(const node_type& v) const {
+            counts_type before, cnt;
+            node_counts(v.offset, v.size, before, cnt);
+            std::array<node_type, arity> res;
+            size_type offset = v.offset + m_size;
+            for (size_type c = 0; c < arity; ++c) {
+                res[c] = node_type(offset, cnt[c], v.level + 1, (v.sym << t_bits) | c);
+                offset += cnt[c];
+            }
+            return res;
+        }
+
+        //! Returns for a range its child ranges
+        /*! \param v An inner node of an wavelet tree.
+         *  \param r A ranges [s,e], such that [s,e] is
+         *           contained in v=[v_s,v_e].
+         *  \return An array containing for each child of v
+         *          the original range mapped to the child.
+         *  \pre !is_leaf(v) and s>=v_s and e<=v_e
+         */
+        std::array<range_type, arity>
+        expand(const node_type& v, const range_type& r) const {
+            counts_type v_sp_rank, sp_rank, ep_rank;
+            m_tree.rank_all(v.offset, v_sp_rank);
+            m_tree.rank_all(v.offset + r[0], sp_rank);
+            m_tree.rank_all(v.offset + r[1] + 1, ep_rank);
+            std::array<range_type, arity> res;
+            for (size_type c = 0; c < arity; ++c) {
+                size_type sp = sp_rank[c] - v_sp_rank[c];
+                res[c] = {{sp, sp + ep_rank[c] - sp_rank[c] - 1}};
+            }
+            return res;
+        }
+
+        //! Returns the child nodes of an inner node and the mapping of a range to them
+        /*! \param v An inner node of an wavelet tree.
+         *  \param r A ranges [s,e], such that [s,e] is
+         *           contained in v=[v_s,v_e].
+         *  \return An array of (node, range) pairs, one for each child.
+         *          Yields the same as expand(v) and expand(v, r),
+         *          but each rank is calculated only once.
+         *  \pre !is_leaf(v) and s>=v_s and e<=v_e
+         */
+        std::array<std::pair<node_type, range_type>, arity>
+        expand_with_range(const node_type& v, const range_type& r) const {
+            counts_type v_sp_rank, v_ep_rank, sp_rank, ep_rank;
+            m_tree.rank_all(v.offset, v_sp_rank);
+            m_tree.rank_all(v.offset + v.size, v_ep_rank);
+            if (r[0] == 0)
+                sp_rank = v_sp_rank;
+            else
+                m_tree.rank_all(v.offset + r[0], sp_rank);
+            if (r[1] + 1 == v.size)
+                ep_rank = v_ep_rank;
+            else
+                m_tree.rank_all(v.offset + r[1] + 1, ep_rank);
+            std::array<std::pair<node_type, range_type>, arity> res;
+            size_type offset = v.offset + m_size;
+            for (size_type c = 0; c < arity; ++c) {
+                size_type child_size = v_ep_rank[c] - v_sp_rank[c];
+                size_type sp = sp_rank[c] - v_sp_rank[c];
+                res[c] = {node_type(offset, child_size, v.level + 1, (v.sym << t_bits) | c),
+                          {{sp, sp + ep_rank[c] - sp_rank[c] - 1}}
+                         };
+                offset += child_size;
+            }
+            return res;
+        }
+
+        //! Return the value range of a node v
+        std::array<value_type, 2>
+        value_range(const node_type& v) const {
+            size_type shift = t_bits*(m_max_level-v.level);
+            if (shift >= 64)
+                return {{0, bits::all_set}};
+            return {{v.sym << shift, (v.sym << shift) + bits::lo_set[shift]}};
+        }
+};
+
+}// end namespace sdsl
+#endif
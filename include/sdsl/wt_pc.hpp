@@ -805,6 +805,33 @@ class wt_pc
             };
         }
 
+        //! Returns the two child nodes of an inner node and the mapping of a range to them
+        /*! \param v An inner node of an wavelet tree.
+         *  \param r A ranges [s,e], such that [s,e] is
+         *           contained in v=[v_s,v_e].
+         *  \return An array of (node, range) pairs (left child, right child).
+         *          Yields the same as expand(v) and expand(v, r),
+         *          but the node's bitvector position is determined only once.
+         *  \pre !is_leaf(v) and s>=v_s and e<=v_e
+         */
+        std::array<std::pair<node_type, range_type>, 2>
+        expand_with_range(const node_type& v, const range_type& r) const {
+            auto v_sp_rank  = m_tree.bv_pos_rank(v);
+            auto bv_pos     = m_tree.bv_pos(v);
+            auto sp_rank    = r[0] == 0 ? v_sp_rank : m_bv_rank(bv_pos + r[0]);
+            auto right_size = m_bv_rank(bv_pos + r[1] + 1)
+                              - sp_rank;
+            auto left_size  = (r[1]-r[0]+1)-right_size;
+
+            auto right_sp = sp_rank - v_sp_rank;
+            auto left_sp  = r[0] - right_sp;
+
+            return {{{m_tree.child(v,0), {{left_sp, left_sp + left_size - 1}}},
+                    {m_tree.child(v,1), {{right_sp, right_sp + right_size - 1}}}
+                }
+            };
+        }
+
         //! return the path to the leaf for a given symbol
         std::pair<uint64_t,uint64_t> path(value_type c) const {
             uint64_t path = m_tree.bit_path(c);
@@ -282,6 +282,38 @@ TEST_F(int_vector_mapper_test, temp_buffer_test)
     }
 }
 
+TEST_F(int_vector_mapper_test, mapped_file)
+{
+    for (const auto& size : vec_sizes) {
+        std::vector<sdsl::int_vector<>> vecs = {sdsl::int_vector<>(size), sdsl::int_vector<>(size/3+1, 0, 7)};
+        sdsl::util::set_to_id(vecs[0]);
+        sdsl::util::set_random_bits(vecs[1], 4711);
+        ASSERT_TRUE(store_to_mapped_file(vecs, temp_dir+"/int_vector_mapped_file_test"));
+        {
+            std::vector<sdsl::int_vector<>> loaded;
+            ASSERT_TRUE(load_from_mapped_file(loaded, temp_dir+"/int_vector_mapped_file_test"));
+            ASSERT_EQ(vecs, loaded);
+            for (const auto& vec : loaded) {
+                ASSERT_TRUE(sdsl::memory_manager::is_mapped(vec.data()));
+                // large data is page aligned, the remaining data word aligned
+                ASSERT_EQ(0u, (uintptr_t)vec.data() % (vec.capacity()/8 >= 4096 ? 4096 : 8));
+            }
+            // writes do not reach the file
+            loaded[1][0] = loaded[1][0] ^ 1;
+            std::vector<sdsl::int_vector<>> reloaded;
+            ASSERT_TRUE(load_from_mapped_file(reloaded, temp_dir+"/int_vector_mapped_file_test"));
+            ASSERT_EQ(vecs, reloaded);
+            ASSERT_NE(vecs[1], loaded[1]);
+            // resizing copies the data
+            loaded[0].resize(size+1);
+            ASSERT_FALSE(sdsl::memory_manager::is_mapped(loaded[0].data()));
+            loaded[0][size] = 42;
+            ASSERT_TRUE(std::equal(vecs[0].begin(), vecs[0].end(), loaded[0].begin()));
+        }
+        sdsl::remove(temp_dir+"/int_vector_mapped_file_test");
+    }
+}
+
 }  // namespace
 
 int main(int argc, char** argv)
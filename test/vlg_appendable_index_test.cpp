@@ -0,0 +1,161 @@
+#include "sdsl/vlg_appendable_index.hpp"
+#include "vlg_test_helper.hpp"
+#include "gtest/gtest.h"
+#include <vector>
+#include <string>
+#include <random>
+
+namespace
+{
+
+using namespace sdsl;
+using namespace std;
+
+typedef int_vector<>::size_type size_type;
+typedef vector<size_type> match_type;
+
+string test_file;
+string temp_file;
+string temp_dir;
+
+typedef vlg_index<> index_type;
+typedef vlg_appendable_index<> appendable_type;
+typedef index_type::query_type query_type;
+
+// Appends the text in pieces of random length.
+void append_pieces(appendable_type& idx, const index_type::text_type& text, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    size_type pos = 0;
+    while (pos < text.size()) {
+        size_type len = std::min((size_type)(1 + rng() % (1 + text.size() / 8)), text.size() - pos);
+        index_type::text_type piece(len);
+        std::copy(text.begin() + pos, text.begin() + pos + len, piece.begin());
+        idx.append(piece);
+        pos += len;
+    }
+}
+
+//! Compare the matches of an appendable index with the ones of an index over the whole text
+TEST(vlg_appendable_index_test, locate)
+{
+    index_type idx;
+    construct(idx, test_file, 1);
+    auto text = load_text(test_file);
+    for (bool background : {false, true}) {
+        appendable_type app(0.5, background);
+        append_pieces(app, text, 3);
+        app.wait();
+        ASSERT_EQ(text.size(), app.size());
+        ASSERT_EQ(text, app.extract(0, text.size() - 1));
+        for (const auto& query : generate_queries(text, 100)) {
+            auto expected = index_matches(idx, query);
+            ASSERT_EQ(expected, app.locate(query));
+            ASSERT_EQ(expected.size(), count(app, query));
+        }
+    }
+}
+
+//! Compare queries with character classes and unbounded gaps, which also straddle segment boundaries
+TEST(vlg_appendable_index_test, classes_and_unbounded_gaps)
+{
+    index_type idx;
+    construct(idx, test_file, 1);
+    auto text = load_text(test_file);
+    appendable_type app(4, false); // merges rarely, so there are many boundaries
+    append_pieces(app, text, 5);
+    std::mt19937_64 rng(7);
+    for (auto query : generate_queries(text, 100)) {
+        add_random_classes(query, text, rng);
+        for (auto& gap : query.gaps) {
+            if (rng() % 2)
+                gap.second = query_type::unbounded();
+        }
+        ASSERT_EQ(index_matches(idx, query), app.locate(query));
+    }
+}
+
+//! Append text while a merge builds an index in the background
+TEST(vlg_appendable_index_test, append_during_merge)
+{
+    index_type idx;
+    construct(idx, test_file, 1);
+    auto text = load_text(test_file);
+    appendable_type app;
+    // the second half triggers a merge of the whole text, which runs while the pieces are appended
+    size_type half = text.size() / 2, quarter = half + (text.size() - half) / 2;
+    for (auto range : {std::make_pair((size_type)0, half), std::make_pair(half, quarter)}) {
+        index_type::text_type piece(range.second - range.first);
+        std::copy(text.begin() + range.first, text.begin() + range.second, piece.begin());
+        app.append(piece);
+    }
+    for (size_type pos = quarter, len = 1 + (text.size() - quarter) / 16; pos < text.size(); pos += len) {
+        index_type::text_type piece(std::min(len, text.size() - pos));
+        std::copy(text.begin() + pos, text.begin() + pos + piece.size(), piece.begin());
+        app.append(piece);
+    }
+    app.wait();
+    ASSERT_EQ(text, app.extract(0, text.size() - 1));
+    for (const auto& query : generate_queries(text, 100))
+        ASSERT_EQ(index_matches(idx, query), app.locate(query));
+}
+
+//! Query the index while text is appended and merged in the background
+TEST(vlg_appendable_index_test, concurrent_queries)
+{
+    auto text = load_text(test_file);
+    auto queries = generate_queries(text, 20);
+    appendable_type app;
+    std::thread appender([&]() { append_pieces(app, text, 11); });
+    while (app.size() < text.size()) {
+        // the matches refer to the prefix of the text which was appended so far
+        for (const auto& query : queries) {
+            for (const auto& match : app.locate(query))
+                ASSERT_LE(match.back() + query.subpatterns.back().size(), text.size());
+        }
+        app.wait(); // runs concurrently with the appends
+    }
+    appender.join();
+    app.merge();
+    ASSERT_EQ(1u, app.segments());
+    index_type idx;
+    construct(idx, test_file, 1);
+    for (const auto& query : queries)
+        ASSERT_EQ(index_matches(idx, query), app.locate(query));
+}
+
+//! Store and load an appendable index
+TEST(vlg_appendable_index_test, store_and_load)
+{
+    auto text = load_text(test_file);
+    appendable_type app(0.5, false);
+    append_pieces(app, text, 13);
+    ASSERT_TRUE(store_to_file(app, temp_file));
+    appendable_type loaded;
+    ASSERT_TRUE(load_from_file(loaded, temp_file));
+    ASSERT_EQ(app.segments(), loaded.segments());
+    ASSERT_EQ(text, loaded.extract(0, text.size() - 1));
+    for (const auto& query : generate_queries(text, 50))
+        ASSERT_EQ(app.locate(query), loaded.locate(query));
+    sdsl::remove(temp_file);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    if (argc < 4) {
+        // LCOV_EXCL_START
+        cout << "Usage: " << argv[0] << " test_file temp_file tmp_dir" << endl;
+        cout << " (1) Appends test_file in pieces to a vlg_appendable_index." << endl;
+        cout << " (2) Performs tests." << endl;
+        cout << " (3) Deletes temp_file." << endl;
+        return 1;
+        // LCOV_EXCL_STOP
+    }
+    test_file = argv[1];
+    temp_file = argv[2];
+    temp_dir  = argv[3];
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,842 @@
+#include "sdsl/vlg_index.hpp"
+#include "gtest/gtest.h"
+#include <vector>
+#include <string>
+#include <random>
+#include <fstream>
+
+namespace
+{
+
+using namespace sdsl;
+using namespace std;
+
+typedef int_vector<>::size_type size_type;
+typedef vector<size_type> match_type;
+
+string test_file;
+string temp_file;
+string temp_dir;
+
+template<class T>
+class vlg_index_test : public ::testing::Test { };
+
+using testing::Types;
+
+typedef Types<
+vlg_index<>,
+vlg_index<byte_alphabet_tag, wt_int_dfs<bit_vector_il<>, rank_support_il<>>>,
+vlg_index<byte_alphabet_tag, wm_int<bit_vector_il<>, rank_support_il<>>>,
+vlg_index<byte_alphabet_tag, wt_int_kary<2>>,
+vlg_index<byte_alphabet_tag, wt_int_kary<3>>,
+vlg_self_index<>
+> Implementations;
+
+TYPED_TEST_CASE(vlg_index_test, Implementations);
+
+// Loads the text of test_file.
+template<class t_index>
+typename t_index::text_type load_text()
+{
+    typename t_index::text_type text;
+    load_vector_from_file(text, test_file, 1);
+    return text;
+}
+
+// Generates gapped queries consisting of text substrings,
+// such that most of the queries have at least one match.
+template<class t_index>
+vector<typename t_index::query_type> generate_queries(const t_index&, size_t num_queries)
+{
+    vector<typename t_index::query_type> queries;
+    std::mt19937_64 rng(13);
+    auto text = load_text<t_index>();
+    auto n = text.size();
+    for (size_t q = 0; q < num_queries; ++q) {
+        typename t_index::query_type query;
+        size_type pos = rng() % n;
+        size_t num_subpatterns = 1 + rng() % 3;
+        for (size_t i = 0; i < num_subpatterns and pos < n; ++i) {
+            size_type len = std::min((size_type)(1 + rng() % 3), n - pos);
+            typename t_index::query_type::string_type subpattern(len);
+            std::copy(text.begin() + pos, text.begin() + pos + len, subpattern.begin());
+            if (i > 0) {
+                uint64_t min_gap = rng() % 8;
+                uint64_t max_gap = min_gap + rng() % 32;
+                auto prev_size = query.subpatterns.back().size();
+                query.gaps.emplace_back(min_gap + prev_size, max_gap + prev_size);
+            }
+            query.subpatterns.push_back(subpattern);
+            pos += len + rng() % 16;
+        }
+        queries.push_back(query);
+    }
+    return queries;
+}
+
+// Collects the matches of a container returned by locate.
+template<class t_container>
+vector<match_type> container_matches(const t_container& res)
+{
+    vector<match_type> matches;
+    for (auto it = res.begin(); it != res.end(); ++it) {
+        match_type match(it.size());
+        for (size_t i = 0; i < it.size(); ++i)
+            match[i] = it[i];
+        matches.push_back(match);
+    }
+    return matches;
+}
+
+template<class t_index>
+vector<match_type> serial_matches(const t_index& idx, const typename t_index::query_type& query)
+{
+    return container_matches(locate(idx, query));
+}
+
+TYPED_TEST(vlg_index_test, create_and_store)
+{
+    TypeParam idx;
+    construct(idx, test_file, 1);
+    ASSERT_TRUE(store_to_file(idx, temp_file));
+}
+
+//! Check that construction keeps the files and settings of the caller's cache config
+TYPED_TEST(vlg_index_test, construct_cache_config)
+{
+    auto caller_file = temp_file + ".caller";
+    {
+        std::ofstream out(caller_file);
+        out << "x";
+    }
+    cache_config config(true, temp_dir);
+    config.file_map["caller"] = caller_file;
+    TypeParam idx;
+    construct(idx, test_file, config, 1);
+    ASSERT_TRUE(config.delete_files);
+    ASSERT_EQ(1U, config.file_map.size());
+    ASSERT_TRUE(std::ifstream(caller_file).good());
+
+    cache_config keep_config(false, temp_dir);
+    keep_config.file_map["caller"] = caller_file;
+    construct(idx, test_file, keep_config, 1);
+    ASSERT_FALSE(keep_config.delete_files);
+    ASSERT_TRUE(keep_config.file_map.count(conf::KEY_SA));
+    ASSERT_TRUE(std::ifstream(caller_file).good());
+    for (const auto& key_file : keep_config.file_map)
+        sdsl::remove(key_file.second);
+}
+
+// Whether the index stores the text, which lets sa_interval place empty intervals at the insertion point.
+template<class t_index>
+bool has_text(const t_index&) { return false; }
+template<class t_alphabet, class t_wt>
+bool has_text(const vlg_index<t_alphabet, t_wt>&) { return true; }
+
+//! Compare the SA intervals of forward_search with the number of occurrences in the text
+TYPED_TEST(vlg_index_test, sa_interval)
+{
+    TypeParam idx;
+    ASSERT_TRUE(load_from_file(idx, temp_file));
+    std::mt19937_64 rng(17);
+    auto text = load_text<TypeParam>();
+    auto n = text.size();
+    auto N = idx.wt.size();
+    for (size_t q = 0; q < 200; ++q) {
+        size_type pos = rng() % n;
+        size_type len = std::min((size_type)(1 + rng() % 8), n - pos);
+        vector<uint64_t> pattern(text.begin() + pos, text.begin() + pos + len);
+        if (q % 4 == 3) // likely does not occur
+            pattern.back() = 1 + rng() % 255;
+        size_type occ = 0;
+        for (size_type i = 0; i + len <= n; ++i)
+            occ += std::equal(pattern.begin(), pattern.end(), text.begin() + i);
+        auto range = idx.sa_interval(pattern.begin(), pattern.end(), 0, N - 1);
+        ASSERT_EQ(occ, range[1] - range[0] + 1) << "q=" << q;
+        for (size_type i = range[0]; i <= range[1]; ++i) {
+            auto p = idx.wt[i];
+            ASSERT_TRUE(p + len <= n and std::equal(pattern.begin(), pattern.end(), text.begin() + p));
+        }
+        // the empty interval is placed at the insertion point
+        if (has_text(idx) and occ == 0 and range[0] < N) {
+            auto p = idx.wt[range[0]];
+            ASSERT_TRUE(std::lexicographical_compare(pattern.begin(), pattern.end(),
+                        text.begin() + p, text.end())) << "q=" << q;
+        }
+    }
+}
+
+//! Extracting the text from the index
+TYPED_TEST(vlg_index_test, extract)
+{
+    TypeParam idx;
+    ASSERT_TRUE(load_from_file(idx, temp_file));
+    auto text = load_text<TypeParam>();
+    std::mt19937_64 rng(19);
+    for (size_t q = 0; q < 100; ++q) {
+        size_type begin = rng() % text.size();
+        size_type end = std::min(begin + rng() % 32, (size_type)text.size() - 1);
+        auto extracted = idx.extract(begin, end);
+        ASSERT_EQ(end - begin + 1, extracted.size());
+        ASSERT_TRUE(std::equal(extracted.begin(), extracted.end(), text.begin() + begin)) << "begin=" << begin;
+    }
+}
+
+//! Compare the SA intervals seeded by the k-gram table with the ones of plain forward_search
+TEST(vlg_index_kmer_test, sa_interval)
+{
+    typedef vlg_index<> index_type;
+    index_type idx;
+    construct(idx, test_file, 1);
+    auto N = idx.wt.size();
+    auto queries = generate_queries(idx, 100);
+    // add subpatterns which do not occur
+    queries.push_back(index_type::query_type(std::string("\1\1\1\1")));
+    queries.push_back(index_type::query_type(std::string("\xff\xff")));
+    // the k-grams of the last suffixes are padded with the 0-symbol
+    index_type::query_type padded;
+    padded.subpatterns.push_back(index_type::query_type::string_type(2, 0));
+    padded.subpatterns.back()[0] = idx.text[idx.text.size() - 1];
+    queries.push_back(padded);
+    vector<range_type> expected;
+    for (const auto& query : queries)
+        for (const auto& sx : query.subpatterns)
+            expected.push_back(idx.sa_interval(sx.begin(), sx.end(), 0, N - 1));
+    for (uint8_t k : {1, 2, 3}) {
+        index_type kmer_idx(idx);
+        kmer_idx.build_kmer_table(k);
+        ASSERT_TRUE(store_to_file(kmer_idx, temp_file + ".kmer"));
+        index_type loaded_idx;
+        ASSERT_TRUE(load_from_file(loaded_idx, temp_file + ".kmer"));
+        sdsl::remove(temp_file + ".kmer");
+        ASSERT_EQ(k, loaded_idx.kmer_length());
+        size_t e = 0;
+        for (const auto& query : queries) {
+            for (const auto& sx : query.subpatterns) {
+                auto range = loaded_idx.sa_interval(sx.begin(), sx.end(), 0, N - 1);
+                if (empty(expected[e]))
+                    ASSERT_TRUE(empty(range)) << "k=" << (int)k;
+                else
+                    ASSERT_EQ(expected[e], range) << "k=" << (int)k;
+                ++e;
+            }
+            ASSERT_EQ(serial_matches(idx, query), serial_matches(loaded_idx, query)) << "k=" << (int)k;
+        }
+    }
+}
+
+//! Load an index stored in the format without k-gram table and documents
+TEST(vlg_index_format_test, load_legacy)
+{
+    typedef vlg_index<> index_type;
+    index_type idx;
+    construct(idx, test_file, 1);
+    auto legacy_file = temp_file + ".legacy";
+    uint64_t trailer = 0x1234;
+    {
+        std::ofstream out(legacy_file, std::ios::binary | std::ios::trunc);
+        idx.text.serialize(out);
+        idx.wt.serialize(out);
+        write_member(trailer, out);
+    }
+    index_type kmer_idx(idx);
+    kmer_idx.build_kmer_table(2);
+    index_type loaded_idx(kmer_idx);
+    {
+        std::ifstream in(legacy_file, std::ios::binary);
+        loaded_idx.load(in);
+        uint64_t loaded_trailer = 0;
+        read_member(loaded_trailer, in);
+        ASSERT_TRUE((bool)in);
+        ASSERT_EQ(trailer, loaded_trailer);
+    }
+    sdsl::remove(legacy_file);
+    ASSERT_EQ(0, loaded_idx.kmer_length());
+    ASSERT_TRUE(std::equal(idx.text.begin(), idx.text.end(), loaded_idx.text.begin()));
+    for (const auto& query : generate_queries(idx, 30))
+        ASSERT_EQ(serial_matches(idx, query), serial_matches(loaded_idx, query));
+}
+
+//! Compare count with the number of matches of the serial iterator
+TYPED_TEST(vlg_index_test, count)
+{
+    TypeParam idx;
+    ASSERT_TRUE(load_from_file(idx, temp_file));
+    for (const auto& query : generate_queries(idx, 100)) {
+        ASSERT_EQ(serial_matches(idx, query).size(), count(idx, query));
+    }
+}
+
+//! Compare locate and count using a reused query context with the serial iterator
+TYPED_TEST(vlg_index_test, query_context)
+{
+    TypeParam idx;
+    ASSERT_TRUE(load_from_file(idx, temp_file));
+    vlg_query_context<TypeParam> context;
+    for (const auto& query : generate_queries(idx, 100)) {
+        auto expected = serial_matches(idx, query);
+        ASSERT_EQ(expected.size(), count(idx, query, context));
+        vector<match_type> matches;
+        auto res = locate(idx, query, context);
+        for (auto it = res.begin(); it != res.end(); ++it) {
+            match_type match(it.size());
+            for (size_t i = 0; i < it.size(); ++i)
+                match[i] = it[i];
+            matches.push_back(match);
+        }
+        ASSERT_EQ(expected, matches);
+    }
+}
+
+//! Check the locate variants reporting the matches to a sink
+TYPED_TEST(vlg_index_test, locate_sink)
+{
+    TypeParam idx;
+    ASSERT_TRUE(load_from_file(idx, temp_file));
+    vlg_query_context<TypeParam> context;
+    for (const auto& query : generate_queries(idx, 100)) {
+        auto expected = serial_matches(idx, query);
+        vector<size_type> expected_starts;
+        for (const auto& match : expected)
+            expected_starts.push_back(match[0]);
+
+        vector<match_type> matches;
+        locate(idx, query, [&](const size_type* begin, const size_type* end) {
+            matches.emplace_back(begin, end);
+        });
+        ASSERT_EQ(expected, matches);
+
+        vector<size_type> starts;
+        locate(idx, query, [&](size_type pos) { starts.push_back(pos); });
+        ASSERT_EQ(expected_starts, starts);
+
+        starts.clear();
+        locate(idx, query, context, std::back_inserter(starts));
+        ASSERT_EQ(expected_starts, starts);
+    }
+}
+
+//! Check that the matches do not depend on the expansion policy
+TYPED_TEST(vlg_index_test, expansion_policies)
+{
+    TypeParam idx;
+    ASSERT_TRUE(load_from_file(idx, temp_file));
+    typedef typename TypeParam::query_type query_type;
+    auto queries = generate_queries(idx, 100);
+    // a symbol of the text followed by itself after an unbounded gap, i.e. x.{0,}x
+    auto text = load_text<TypeParam>();
+    query_type repeated;
+    repeated.subpatterns.assign(2, typename query_type::string_type(1, text[text.size() / 2]));
+    repeated.gaps.emplace_back(1, query_type::unbounded());
+    queries.push_back(repeated);
+    for (auto expansion : {vlg_expansion::largest_node, vlg_expansion::rarest_anchor, vlg_expansion::gap_slack}) {
+        vlg_query_context<TypeParam> context;
+        context.set_expansion(expansion);
+        for (const auto& query : queries) {
+            vector<match_type> matches;
+            locate(idx, query, context, [&](const size_type* begin, const size_type* end) {
+                matches.emplace_back(begin, end);
+            });
+            ASSERT_EQ(serial_matches(idx, query), matches) << expansion_name(expansion);
+        }
+    }
+}
+
+//! Compare locate using walkers which extract small ranges at once with the serial iterator
+TYPED_TEST(vlg_index_test, hybrid_walker)
+{
+    typedef vlg_query_context<TypeParam, wt_hybrid_range_walker<typename TypeParam::wt_type>> context_type;
+    TypeParam idx;
+    ASSERT_TRUE(load_from_file(idx, temp_file));
+    auto queries = generate_queries(idx, 100);
+    for (size_t cutoff : {1, 8, 1000000}) {
+        typename context_type::options_type options;
+        options.cutoff = cutoff;
+        context_type context(options);
+        for (const auto& query : queries) {
+            auto expected = serial_matches(idx, query);
+            ASSERT_EQ(expected.size(), count(idx, query, context)) << "cutoff=" << cutoff;
+            vector<match_type> matches;
+            auto res = locate(idx, query, context);
+            for (auto it = res.begin(); it != res.end(); ++it) {
+                match_type match(it.size());
+                for (size_t i = 0; i < it.size(); ++i)
+                    match[i] = it[i];
+                matches.push_back(match);
+            }
+            ASSERT_EQ(expected, matches) << "cutoff=" << cutoff;
+        }
+    }
+}
+
+//! Compare parallel locate with the serial iterator
+TYPED_TEST(vlg_index_test, locate_parallel)
+{
+    TypeParam idx;
+    ASSERT_TRUE(load_from_file(idx, temp_file));
+    for (const auto& query : generate_queries(idx, 100)) {
+        auto expected = serial_matches(idx, query);
+        for (size_t num_threads : {1, 2, 3, 8}) {
+            auto matches = locate_parallel(idx, query, num_threads);
+            ASSERT_EQ(expected, matches) << "num_threads=" << num_threads;
+        }
+    }
+}
+
+//! Compare batched locate with locating each query separately
+TYPED_TEST(vlg_index_test, locate_batch)
+{
+    TypeParam idx;
+    ASSERT_TRUE(load_from_file(idx, temp_file));
+    auto queries = generate_queries(idx, 100);
+    // add duplicates and subpatterns which do not occur
+    queries.push_back(queries[0]);
+    queries.push_back(typename TypeParam::query_type(std::string("\1\1\1")));
+    auto results = locate_batch(idx, queries);
+    ASSERT_EQ(queries.size(), results.size());
+    for (size_t q = 0; q < queries.size(); ++q) {
+        auto expected = serial_matches(idx, queries[q]);
+        vector<match_type> matches;
+        for (auto it = results[q].begin(); it != results[q].end(); ++it) {
+            match_type match(it.size());
+            for (size_t i = 0; i < it.size(); ++i)
+                match[i] = it[i];
+            matches.push_back(match);
+        }
+        ASSERT_EQ(expected, matches) << "q=" << q;
+    }
+}
+
+//! Compare level-synchronous matching with the serial iterator
+TYPED_TEST(vlg_index_test, level_engine)
+{
+    TypeParam idx;
+    ASSERT_TRUE(load_from_file(idx, temp_file));
+    vlg_level_engine<TypeParam> engine(idx);
+    auto queries = generate_queries(idx, 100);
+    queries.push_back(typename TypeParam::query_type(std::string("\1\1\1")));
+    for (const auto& query : queries) {
+        ASSERT_EQ(serial_matches(idx, query), engine.locate(query));
+    }
+}
+
+// Determines the matches of a query by scanning the text for each subpattern.
+template<class t_index>
+vector<match_type> scan_matches(const typename t_index::text_type& text, const typename t_index::query_type& query)
+{
+    size_t m = query.subpatterns.size();
+    vector<vector<size_type>> positions(m);
+    for (size_t i = 0; i < m; ++i) {
+        size_type len = query.subpatterns[i].size();
+        for (size_type p = 0; p + len <= text.size(); ++p) {
+            if (query.matches(i, text.begin() + p))
+                positions[i].push_back(p);
+        }
+        if (positions[i].empty())
+            return {};
+    }
+    vector<match_type> result;
+    match_sorted_positions(positions, query.gaps, query.subpatterns.back().size(),
+    [](size_type p) { return p; }, result);
+    return result;
+}
+
+//! Compare queries containing character classes with a scan of the text
+TYPED_TEST(vlg_index_test, character_classes)
+{
+    TypeParam idx;
+    ASSERT_TRUE(load_from_file(idx, temp_file));
+    auto text = load_text<TypeParam>();
+    vlg_level_engine<TypeParam> engine(idx);
+    vlg_planner<TypeParam> planner(idx);
+    std::mt19937_64 rng(17);
+    vector<typename TypeParam::query_type> queries;
+    for (auto query : generate_queries(idx, 100)) {
+        // replace some symbols by classes containing a further symbol of the text
+        query.classes.resize(query.subpatterns.size());
+        for (size_t i = 0; i < query.subpatterns.size(); ++i) {
+            for (size_t j = 0; j < query.subpatterns[i].size(); ++j) {
+                typename TypeParam::query_type::class_type symbol_class = {query.subpatterns[i][j]};
+                if (rng() % 2)
+                    symbol_class.push_back(text[rng() % text.size()]);
+                std::sort(symbol_class.begin(), symbol_class.end());
+                symbol_class.erase(std::unique(symbol_class.begin(), symbol_class.end()), symbol_class.end());
+                query.subpatterns[i][j] = symbol_class[0];
+                query.classes[i].push_back(symbol_class);
+            }
+        }
+        auto expected = scan_matches<TypeParam>(text, query);
+        ASSERT_EQ(expected.size(), count(idx, query));
+        vector<match_type> matches;
+        locate(idx, query, [&](const size_type* begin, const size_type* end) {
+            matches.emplace_back(begin, end);
+        });
+        ASSERT_EQ(expected, matches);
+        ASSERT_EQ(expected, engine.locate(query));
+        ASSERT_EQ(expected, planner.locate(query));
+        auto plan = planner.last_plan();
+        for (auto strategy : {vlg_strategy::wt_traversal, vlg_strategy::sa_merge,
+                              vlg_strategy::text_scan, vlg_strategy::anchor_verify}) {
+            if (std::isinf(plan.cost(strategy)))
+                continue;
+            plan.strategy = strategy;
+            ASSERT_EQ(expected, planner.locate(query, plan)) << strategy_name(strategy);
+        }
+        queries.push_back(query);
+    }
+    // batched iterators using a single-range walker only support classes matching a single SA interval
+    typedef wt_multi_range_walker<typename TypeParam::wt_type> multi_walker;
+    range_vec_type intervals;
+    bool several_intervals = false;
+    for (const auto& query : queries) {
+        for (size_t i = 0; i < query.subpatterns.size(); ++i) {
+            vlg_iterator<TypeParam, multi_walker>::subpattern_intervals(idx, query, i, intervals);
+            several_intervals = several_intervals or intervals.size() > 1;
+        }
+    }
+    if (several_intervals) {
+        ASSERT_THROW((locate_batch<TypeParam, wt_range_walker<typename TypeParam::wt_type>>(idx, queries)),
+                     std::invalid_argument);
+    }
+    auto results = locate_batch<TypeParam, multi_walker>(idx, queries);
+    auto adaptive_results = locate_batch(idx, queries);
+    for (size_t q = 0; q < queries.size(); ++q) {
+        auto expected = scan_matches<TypeParam>(text, queries[q]);
+        ASSERT_EQ(expected, container_matches(results[q])) << "q=" << q;
+        ASSERT_EQ(expected, container_matches(adaptive_results[q])) << "q=" << q;
+        ASSERT_EQ(expected, serial_matches(idx, queries[q])) << "q=" << q;
+        ASSERT_EQ(expected, locate_parallel(idx, queries[q], 3)) << "q=" << q;
+    }
+}
+
+//! Compare queries whose subpatterns tolerate mismatches with a scan of the text
+TYPED_TEST(vlg_index_test, mismatches)
+{
+    TypeParam idx;
+    ASSERT_TRUE(load_from_file(idx, temp_file));
+    auto text = load_text<TypeParam>();
+    vlg_level_engine<TypeParam> engine(idx);
+    vlg_planner<TypeParam> planner(idx);
+    std::mt19937_64 rng(19);
+    for (auto query : generate_queries(idx, 50)) {
+        for (const auto& subpattern : query.subpatterns)
+            query.mismatches.push_back(rng() % subpattern.size());
+        auto expected = scan_matches<TypeParam>(text, query);
+        ASSERT_EQ(expected.size(), count(idx, query));
+        vector<match_type> matches;
+        locate(idx, query, [&](const size_type* begin, const size_type* end) {
+            matches.emplace_back(begin, end);
+        });
+        ASSERT_EQ(expected, matches);
+        ASSERT_EQ(expected, engine.locate(query));
+        ASSERT_EQ(expected, planner.locate(query));
+    }
+}
+
+//! Compare queries with unbounded gaps with a scan of the text
+TYPED_TEST(vlg_index_test, unbounded_gaps)
+{
+    typedef typename TypeParam::query_type query_type;
+    TypeParam idx;
+    ASSERT_TRUE(load_from_file(idx, temp_file));
+    auto text = load_text<TypeParam>();
+    vlg_level_engine<TypeParam> engine(idx);
+    vlg_planner<TypeParam> planner(idx);
+    std::mt19937_64 rng(23);
+    for (auto query : generate_queries(idx, 100)) {
+        for (auto& gap : query.gaps) {
+            if (rng() % 2)
+                gap.second = query_type::unbounded();
+        }
+        auto expected = scan_matches<TypeParam>(text, query);
+        ASSERT_EQ(expected, serial_matches(idx, query));
+        ASSERT_EQ(expected.size(), count(idx, query));
+        ASSERT_EQ(expected, engine.locate(query));
+        ASSERT_EQ(expected, planner.locate(query));
+        auto plan = planner.plan(query);
+        plan.strategy = vlg_strategy::anchor_verify;
+        if (!std::isinf(plan.cost(plan.strategy))) {
+            ASSERT_EQ(expected, planner.locate(query, plan));
+        }
+        auto estimate = engine.estimate_count(query, 64);
+        ASSERT_LE(estimate.lower, expected.size());
+        ASSERT_GE(estimate.upper, expected.size());
+    }
+}
+
+//! Map an index stored by store_to_mapped_file and compare it with the loaded index
+TYPED_TEST(vlg_index_test, mapped_file)
+{
+    TypeParam idx;
+    ASSERT_TRUE(load_from_file(idx, temp_file));
+    auto mapped_file = temp_file + "_mapped";
+    ASSERT_TRUE(store_to_mapped_file(idx, mapped_file));
+    {
+        TypeParam mapped;
+        ASSERT_TRUE(load_from_mapped_file(mapped, mapped_file));
+        ASSERT_EQ(idx.wt.size(), mapped.wt.size());
+        ASSERT_EQ(size_in_bytes(idx), size_in_bytes(mapped));
+        for (const auto& query : generate_queries(idx, 100))
+            ASSERT_EQ(serial_matches(idx, query), serial_matches(mapped, query));
+    }
+    sdsl::remove(mapped_file);
+}
+
+//! Check the parsing of character classes and case-insensitive queries
+TEST(gapped_pattern_query_test, character_classes)
+{
+    typedef vlg_index<>::query_type query_type;
+    query_type query("[Cc]olo.{0,3}?[a-c]");
+    ASSERT_EQ(2u, query.subpatterns.size());
+    ASSERT_FALSE(query.is_literal(0));
+    ASSERT_FALSE(query.is_literal(1));
+    ASSERT_EQ((query_type::class_type {'C', 'c'}), query.classes[0][0]);
+    ASSERT_EQ((query_type::class_type {'a', 'b', 'c'}), query.classes[1][0]);
+    ASSERT_TRUE(query.matches(0, 0, 'c'));
+    ASSERT_FALSE(query.matches(0, 1, 'O'));
+
+    ASSERT_FALSE(query_type("colo.{0,3}?r").has_classes());
+
+    query_type ignore_case("colo.{0,3}?r", true);
+    ASSERT_TRUE(ignore_case.has_classes());
+    ASSERT_TRUE(ignore_case.matches(0, 1, 'O'));
+    ASSERT_TRUE(ignore_case.matches(1, 0, 'R'));
+    ASSERT_FALSE(ignore_case.matches(1, 0, 's'));
+}
+
+//! Check the parsing of mismatch budgets
+TEST(gapped_pattern_query_test, mismatches)
+{
+    typedef vlg_index<>::query_type query_type;
+    query_type query("ACGT{~1}.{0,3}?GG");
+    ASSERT_EQ(2u, query.subpatterns.size());
+    ASSERT_EQ(4u, query.subpatterns[0].size());
+    ASSERT_EQ(1u, query.mismatch_budget(0));
+    ASSERT_EQ(0u, query.mismatch_budget(1));
+    ASSERT_FALSE(query.is_literal(0));
+    ASSERT_TRUE(query.is_literal(1));
+    ASSERT_FALSE(query.has_classes());
+    std::string text = "ACCTGG";
+    ASSERT_TRUE(query.matches(0, text.begin()));
+    ASSERT_FALSE(query.matches(0, text.begin() + 1));
+
+    ASSERT_TRUE(query_type("ACGT.{0,3}?GG").is_literal());
+}
+
+//! Check the parsing of unbounded gaps
+TEST(gapped_pattern_query_test, unbounded_gaps)
+{
+    typedef vlg_index<>::query_type query_type;
+    query_type query("ab.{2,}?c.{0,3}?d");
+    ASSERT_EQ(3u, query.subpatterns.size());
+    ASSERT_EQ(make_pair((uint64_t)4, query_type::unbounded()), query.gaps[0]);
+    ASSERT_TRUE(query.is_unbounded(0));
+    ASSERT_FALSE(query.is_unbounded(1));
+    ASSERT_THROW(query_type("ab.{2,}c"), std::runtime_error);
+}
+
+//! Locate a class matching several SA intervals with each locate variant
+TEST(vlg_index_class_test, locate)
+{
+    vlg_index<> idx;
+    construct_im(idx, std::string("abcabdabeacbxaybzab"), 1);
+    vlg_index<>::query_type query("[ac]b.{0,3}?b");
+    vector<match_type> expected = {{0, 4}, {6, 11}};
+    ASSERT_EQ(expected.size(), count(idx, query));
+    ASSERT_EQ(expected, serial_matches(idx, query));
+    for (size_t threads : {1, 2, 4})
+        ASSERT_EQ(expected, locate_parallel(idx, query, threads));
+}
+
+//! Check that the estimated number of occurrences respects its bounds
+TYPED_TEST(vlg_index_test, estimate_count)
+{
+    TypeParam idx;
+    ASSERT_TRUE(load_from_file(idx, temp_file));
+    vlg_level_engine<TypeParam> engine(idx);
+    for (const auto& query : generate_queries(idx, 100)) {
+        uint64_t expected = serial_matches(idx, query).size();
+        for (size_t budget : {(size_t)0, (size_t)16, (size_t)256}) {
+            auto estimate = engine.estimate_count(query, budget);
+            ASSERT_LE(estimate.nodes, budget);
+            ASSERT_LE(estimate.lower, expected) << "budget=" << budget;
+            ASSERT_GE(estimate.upper, expected) << "budget=" << budget;
+            ASSERT_LE(estimate.lower, estimate.estimate);
+            ASSERT_GE(estimate.upper, estimate.estimate);
+            if (estimate.exact) {
+                ASSERT_EQ(expected, estimate.estimate);
+            }
+        }
+        auto estimate = estimate_count(idx, query, std::numeric_limits<size_t>::max());
+        ASSERT_TRUE(estimate.exact);
+        ASSERT_EQ(expected, estimate.estimate);
+    }
+}
+
+//! Check that matches do not cross document boundaries
+TYPED_TEST(vlg_index_test, documents)
+{
+    TypeParam idx;
+    ASSERT_TRUE(load_from_file(idx, temp_file));
+    size_type n = idx.wt.size() - 1;
+    std::mt19937_64 rng(7);
+    bit_vector starts(n, 0);
+    vector<size_type> doc_begin = {0};
+    for (size_type i = 1 + rng() % 40; i < n; i += 1 + rng() % 40) {
+        starts[i] = 1;
+        doc_begin.push_back(i);
+    }
+    doc_begin.push_back(n);
+    TypeParam doc_idx(idx);
+    doc_idx.set_documents(vlg_documents(starts));
+    ASSERT_EQ(doc_begin.size() - 1, doc_idx.documents.size());
+    ASSERT_TRUE(store_to_file(doc_idx, temp_file + ".docs"));
+    TypeParam loaded_idx;
+    ASSERT_TRUE(load_from_file(loaded_idx, temp_file + ".docs"));
+    sdsl::remove(temp_file + ".docs");
+
+    vlg_level_engine<TypeParam> engine(doc_idx);
+    vlg_planner<TypeParam> planner(doc_idx);
+    for (const auto& query : generate_queries(idx, 30)) {
+        // within a document, the first match crossing its end is followed by no further match
+        vector<match_type> expected;
+        vector<pair<size_type, size_type>> expected_offsets;
+        auto ranges = vlg_iterator<TypeParam>::subpattern_ranges(idx, query);
+        if (ranges.size() == query.subpatterns.size() and !empty(ranges.back())) {
+            for (size_t d = 0; d + 1 < doc_begin.size(); ++d) {
+                vlg_iterator<TypeParam> it(idx, query, ranges, doc_begin[d], doc_begin[d + 1]);
+                for (; !it.is_end(); ++it) {
+                    if (it[it.size() - 1] + query.subpatterns.back().size() > doc_begin[d + 1])
+                        break;
+                    match_type match(it.size());
+                    for (size_t i = 0; i < it.size(); ++i)
+                        match[i] = it[i];
+                    expected.push_back(match);
+                    expected_offsets.emplace_back(d, it[0] - doc_begin[d]);
+                }
+            }
+        }
+        ASSERT_EQ(expected, serial_matches(doc_idx, query));
+        ASSERT_EQ(expected, serial_matches(loaded_idx, query));
+        ASSERT_EQ(expected, engine.locate(query));
+        auto plan = planner.plan(query);
+        for (auto strategy : {vlg_strategy::wt_traversal, vlg_strategy::sa_merge,
+                              vlg_strategy::text_scan, vlg_strategy::anchor_verify}) {
+            if (std::isinf(plan.cost(strategy)))
+                continue;
+            plan.strategy = strategy;
+            ASSERT_EQ(expected, planner.locate(query, plan)) << strategy_name(strategy);
+        }
+        ASSERT_EQ(expected_offsets, locate_documents(doc_idx, query));
+    }
+}
+
+//! Compare document listing with the documents of all matches
+TYPED_TEST(vlg_index_test, list_documents)
+{
+    TypeParam idx;
+    ASSERT_TRUE(load_from_file(idx, temp_file));
+    size_type n = idx.wt.size() - 1;
+    std::mt19937_64 rng(11);
+    bit_vector starts(n, 0);
+    for (size_type i = 1 + rng() % 100; i < n; i += 1 + rng() % 100)
+        starts[i] = 1;
+    idx.set_documents(vlg_documents(starts));
+    for (const auto& query : generate_queries(idx, 100)) {
+        vector<pair<size_type, size_type>> expected;
+        vector<size_type> expected_docs;
+        for (const auto& match : locate_documents(idx, query)) {
+            if (expected.empty() or expected.back().first != match.first) {
+                expected.emplace_back(match.first, 0);
+                expected_docs.push_back(match.first);
+            }
+            ++expected.back().second;
+        }
+        ASSERT_EQ(expected_docs, list_documents(idx, query));
+        ASSERT_EQ(expected, list_documents_with_frequency(idx, query));
+    }
+}
+
+//! Check the document boundaries induced by a separator symbol
+TEST(vlg_documents_test, separator)
+{
+    auto text = load_text<vlg_index<>>();
+    if (text.empty())
+        return;
+    auto separator = text[text.size() / 2];
+    vlg_documents docs(text, separator);
+    size_type doc = 0, begin = 0;
+    for (size_type i = 0; i < text.size(); ++i) {
+        ASSERT_EQ(doc, docs.document(i));
+        ASSERT_EQ(begin, docs.document_begin(doc));
+        ASSERT_EQ(make_pair(doc, i - begin), docs.document_offset(i));
+        if (text[i] == separator and i + 1 < text.size()) {
+            ++doc;
+            begin = i + 1;
+        }
+    }
+    ASSERT_EQ(doc + 1, docs.size());
+}
+
+//! Compare each strategy of the planner with the serial iterator
+TYPED_TEST(vlg_index_test, planner)
+{
+    TypeParam idx;
+    ASSERT_TRUE(load_from_file(idx, temp_file));
+    vlg_planner<TypeParam> planner(idx);
+    auto queries = generate_queries(idx, 100);
+    queries.push_back(typename TypeParam::query_type(std::string("\1\1\1")));
+    for (const auto& query : queries) {
+        auto expected = serial_matches(idx, query);
+        ASSERT_EQ(expected, planner.locate(query));
+        auto plan = planner.last_plan();
+        ASSERT_EQ(plan.cost(plan.strategy), *std::min_element(plan.costs.begin(), plan.costs.end()));
+        for (auto strategy : {vlg_strategy::wt_traversal, vlg_strategy::sa_merge,
+                              vlg_strategy::text_scan, vlg_strategy::anchor_verify}) {
+            if (std::isinf(plan.cost(strategy)))
+                continue;
+            plan.strategy = strategy;
+            ASSERT_EQ(expected, planner.locate(query, plan)) << strategy_name(strategy);
+        }
+    }
+}
+
+//! Compare the matches of the wavelet matrix based index with the ones of the wavelet tree based index
+TEST(vlg_index_wm_test, locate)
+{
+    vlg_index<> wt_idx;
+    construct(wt_idx, test_file, 1);
+    vlg_index<byte_alphabet_tag, wm_int<>> wm_idx;
+    construct(wm_idx, test_file, 1);
+    vlg_level_engine<vlg_index<byte_alphabet_tag, wm_int<>>> engine(wm_idx);
+    for (const auto& query : generate_queries(wt_idx, 100)) {
+        auto expected = serial_matches(wt_idx, query);
+        ASSERT_EQ(expected, serial_matches(wm_idx, query));
+        ASSERT_EQ(expected, engine.locate(query));
+    }
+}
+
+TYPED_TEST(vlg_index_test, delete_)
+{
+    sdsl::remove(temp_file);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    if (argc < 4) {
+        // LCOV_EXCL_START
+        cout << "Usage: " << argv[0] << " test_file temp_file tmp_dir" << endl;
+        cout << " (1) Generates a vlg_index out of test_file; stores it in temp_file." << endl;
+        cout << " (2) Performs tests." << endl;
+        cout << " (3) Deletes temp_file." << endl;
+        return 1;
+        // LCOV_EXCL_STOP
+    }
+    test_file = argv[1];
+    temp_file = argv[2];
+    temp_dir  = argv[3];
+    return RUN_ALL_TESTS();
+}
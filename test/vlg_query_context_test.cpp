@@ -0,0 +1,148 @@
+#include "sdsl/vlg_index.hpp"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <string>
+#include <random>
+
+// Number of calls of the global operator new, which is replaced to count allocations.
+static std::atomic<size_t> num_allocations(0);
+
+// GCC pairs the inlined std::free of the replaced operator delete with the
+// replaced operator new and reports a false mismatch.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size)
+{
+    ++num_allocations;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+namespace
+{
+
+using namespace sdsl;
+using namespace std;
+
+typedef int_vector<>::size_type size_type;
+
+string test_file;
+
+template<class T>
+class vlg_query_context_test : public ::testing::Test { };
+
+using testing::Types;
+
+typedef Types<
+vlg_index<>,
+vlg_index<byte_alphabet_tag, wt_int_dfs<bit_vector_il<>, rank_support_il<>>>,
+vlg_index<byte_alphabet_tag, wm_int<bit_vector_il<>, rank_support_il<>>>,
+vlg_index<byte_alphabet_tag, wt_int_kary<2>>,
+vlg_index<byte_alphabet_tag, wt_int_kary<3>>,
+vlg_self_index<>
+> Implementations;
+
+TYPED_TEST_CASE(vlg_query_context_test, Implementations);
+
+// Generates gapped queries consisting of text substrings,
+// such that most of the queries have at least one match.
+template<class t_index>
+vector<typename t_index::query_type> generate_queries(size_t num_queries)
+{
+    vector<typename t_index::query_type> queries;
+    std::mt19937_64 rng(13);
+    typename t_index::text_type text;
+    load_vector_from_file(text, test_file, 1);
+    auto n = text.size();
+    for (size_t q = 0; q < num_queries; ++q) {
+        typename t_index::query_type query;
+        size_type pos = rng() % n;
+        size_t num_subpatterns = 1 + rng() % 3;
+        for (size_t i = 0; i < num_subpatterns and pos < n; ++i) {
+            size_type len = std::min((size_type)(1 + rng() % 3), n - pos);
+            typename t_index::query_type::string_type subpattern(len);
+            std::copy(text.begin() + pos, text.begin() + pos + len, subpattern.begin());
+            if (i > 0) {
+                uint64_t min_gap = rng() % 8;
+                uint64_t max_gap = min_gap + rng() % 32;
+                auto prev_size = query.subpatterns.back().size();
+                query.gaps.emplace_back(min_gap + prev_size, max_gap + prev_size);
+            }
+            query.subpatterns.push_back(subpattern);
+            pos += len + rng() % 16;
+        }
+        queries.push_back(query);
+    }
+    return queries;
+}
+
+// Runs count and locate for each query using a context and returns the number of reported positions.
+template<class t_index, class t_context>
+size_type run_with_context(const t_index& idx, const vector<typename t_index::query_type>& queries, t_context& context)
+{
+    size_type result = 0;
+    for (const auto& query : queries) {
+        result += count(idx, query, context);
+        auto res = locate(idx, query, context);
+        for (auto it = res.begin(); it != res.end(); ++it)
+            result += it.size();
+        locate(idx, query, context, [&](const size_type* begin, const size_type* end) {
+            result += end - begin;
+        });
+    }
+    return result;
+}
+
+//! Check that a warmed-up query context answers repeated queries without allocating memory
+TYPED_TEST(vlg_query_context_test, allocations)
+{
+    TypeParam idx;
+    construct(idx, test_file, 1);
+    auto queries = generate_queries<TypeParam>(50);
+    for (auto expansion : {vlg_expansion::largest_node, vlg_expansion::rarest_anchor, vlg_expansion::gap_slack}) {
+        vlg_query_context<TypeParam> context;
+        context.set_expansion(expansion);
+        auto expected = run_with_context(idx, queries, context);
+        size_t before = num_allocations;
+        ASSERT_EQ(expected, run_with_context(idx, queries, context));
+        ASSERT_EQ(before, num_allocations.load()) << expansion_name(expansion);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    if (argc < 2) {
+        // LCOV_EXCL_START
+        cout << "Usage: " << argv[0] << " test_file" << endl;
+        cout << " (1) Generates a vlg_index out of test_file." << endl;
+        cout << " (2) Checks that warmed-up query contexts do not allocate memory." << endl;
+        return 1;
+        // LCOV_EXCL_STOP
+    }
+    test_file = argv[1];
+    return RUN_ALL_TESTS();
+}
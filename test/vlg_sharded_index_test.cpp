@@ -0,0 +1,111 @@
+#include "sdsl/vlg_sharded_index.hpp"
+#include "vlg_test_helper.hpp"
+#include "gtest/gtest.h"
+#include <vector>
+#include <string>
+#include <random>
+
+namespace
+{
+
+using namespace sdsl;
+using namespace std;
+
+typedef int_vector<>::size_type size_type;
+typedef vector<size_type> match_type;
+
+string test_file;
+string temp_file;
+string temp_dir;
+
+typedef vlg_index<> index_type;
+typedef vlg_sharded_index<> sharded_type;
+typedef index_type::query_type query_type;
+
+//! Compare the matches of a sharded index with the ones of an index over the whole text
+TEST(vlg_sharded_index_test, locate)
+{
+    index_type idx;
+    construct(idx, test_file, 1);
+    auto text = load_text(test_file);
+    auto queries = generate_queries(text, 100);
+    for (size_type shard_size : {(size_type)1, (size_type)7, (size_type)1000, text.size()}) {
+        for (size_t num_threads : {1, 4}) {
+            sharded_type sharded(text, shard_size, 100, num_threads);
+            ASSERT_EQ(text.size(), sharded.size());
+            ASSERT_EQ((text.size() + shard_size - 1) / shard_size, sharded.shards());
+            ASSERT_EQ(text, sharded.extract(0, text.size() - 1));
+            for (const auto& query : queries) {
+                ASSERT_TRUE(sharded.supports(query));
+                auto expected = index_matches(idx, query);
+                ASSERT_EQ(expected, sharded.locate(query));
+                ASSERT_EQ(expected.size(), count(sharded, query));
+            }
+        }
+    }
+}
+
+//! Compare queries with character classes and reject queries spanning more than the overlap
+TEST(vlg_sharded_index_test, classes_and_overlap)
+{
+    index_type idx;
+    construct(idx, test_file, 1);
+    auto text = load_text(test_file);
+    sharded_type sharded(text, 50, 100);
+    std::mt19937_64 rng(7);
+    for (auto query : generate_queries(text, 100)) {
+        add_random_classes(query, text, rng);
+        ASSERT_EQ(index_matches(idx, query), sharded.locate(query));
+        if (!query.gaps.empty() and text.size() > sharded.overlap()) {
+            query.gaps.back().second = query_type::unbounded();
+            ASSERT_FALSE(sharded.supports(query));
+            ASSERT_THROW(sharded.locate(query), std::invalid_argument);
+        }
+    }
+}
+
+//! Store and load a sharded index
+TEST(vlg_sharded_index_test, store_and_load)
+{
+    auto text = load_text(test_file);
+    sharded_type sharded(text, 100, 100);
+    ASSERT_TRUE(store_to_file(sharded, temp_file));
+    sharded_type loaded;
+    ASSERT_TRUE(load_from_file(loaded, temp_file));
+    ASSERT_EQ(sharded.shards(), loaded.shards());
+    ASSERT_EQ(text, loaded.extract(0, text.size() - 1));
+    for (const auto& query : generate_queries(text, 50))
+        ASSERT_EQ(sharded.locate(query), loaded.locate(query));
+    sdsl::remove(temp_file);
+}
+
+//! Store and load a default constructed sharded index
+TEST(vlg_sharded_index_test, store_and_load_empty)
+{
+    sharded_type empty_index;
+    ASSERT_TRUE(store_to_file(empty_index, temp_file));
+    sharded_type loaded;
+    ASSERT_TRUE(load_from_file(loaded, temp_file));
+    ASSERT_EQ(0U, loaded.shards());
+    sdsl::remove(temp_file);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    if (argc < 4) {
+        // LCOV_EXCL_START
+        cout << "Usage: " << argv[0] << " test_file temp_file tmp_dir" << endl;
+        cout << " (1) Generates a vlg_sharded_index out of test_file; stores it in temp_file." << endl;
+        cout << " (2) Performs tests." << endl;
+        cout << " (3) Deletes temp_file." << endl;
+        return 1;
+        // LCOV_EXCL_STOP
+    }
+    test_file = argv[1];
+    temp_file = argv[2];
+    temp_dir  = argv[3];
+    return RUN_ALL_TESTS();
+}
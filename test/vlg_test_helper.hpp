@@ -0,0 +1,81 @@
+#ifndef SDSL_TEST_VLG_HELPER
+#define SDSL_TEST_VLG_HELPER
+
+#include "sdsl/vlg_index.hpp"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+typedef sdsl::vlg_index<>                            vlg_helper_index_type;
+typedef vlg_helper_index_type::text_type             vlg_helper_text_type;
+typedef vlg_helper_index_type::query_type            vlg_helper_query_type;
+typedef std::vector<vlg_helper_index_type::size_type> vlg_helper_match_type;
+
+// Loads the byte text of file.
+inline vlg_helper_text_type load_text(const std::string& file)
+{
+    vlg_helper_text_type text;
+    sdsl::load_vector_from_file(text, file, 1);
+    return text;
+}
+
+// Generates gapped queries consisting of text substrings.
+inline std::vector<vlg_helper_query_type> generate_queries(const vlg_helper_text_type& text, size_t num_queries)
+{
+    typedef vlg_helper_index_type::size_type size_type;
+    std::vector<vlg_helper_query_type> queries;
+    std::mt19937_64 rng(13);
+    auto n = text.size();
+    for (size_t q = 0; q < num_queries; ++q) {
+        vlg_helper_query_type query;
+        size_type pos = rng() % n;
+        size_t num_subpatterns = 1 + rng() % 3;
+        for (size_t i = 0; i < num_subpatterns and pos < n; ++i) {
+            size_type len = std::min((size_type)(1 + rng() % 3), n - pos);
+            vlg_helper_query_type::string_type subpattern(len);
+            std::copy(text.begin() + pos, text.begin() + pos + len, subpattern.begin());
+            if (i > 0) {
+                uint64_t min_gap = rng() % 8;
+                uint64_t max_gap = min_gap + rng() % 32;
+                auto prev_size = query.subpatterns.back().size();
+                query.gaps.emplace_back(min_gap + prev_size, max_gap + prev_size);
+            }
+            query.subpatterns.push_back(subpattern);
+            pos += len + rng() % 16;
+        }
+        queries.push_back(query);
+    }
+    return queries;
+}
+
+// Collects the matches reported by the sink variant of locate.
+inline std::vector<vlg_helper_match_type> index_matches(const vlg_helper_index_type& idx, const vlg_helper_query_type& query)
+{
+    typedef vlg_helper_index_type::size_type size_type;
+    std::vector<vlg_helper_match_type> matches;
+    locate(idx, query, [&](const size_type* begin, const size_type* end) {
+        matches.emplace_back(begin, end);
+    });
+    return matches;
+}
+
+// Turns each symbol of the query into a character class, which contains a random
+// text symbol in addition to the original one with probability 1/2.
+inline void add_random_classes(vlg_helper_query_type& query, const vlg_helper_text_type& text, std::mt19937_64& rng)
+{
+    query.classes.resize(query.subpatterns.size());
+    for (size_t i = 0; i < query.subpatterns.size(); ++i) {
+        for (size_t j = 0; j < query.subpatterns[i].size(); ++j) {
+            vlg_helper_query_type::class_type symbol_class = {query.subpatterns[i][j]};
+            if (rng() % 2)
+                symbol_class.push_back(text[rng() % text.size()]);
+            std::sort(symbol_class.begin(), symbol_class.end());
+            symbol_class.erase(std::unique(symbol_class.begin(), symbol_class.end()), symbol_class.end());
+            query.subpatterns[i][j] = symbol_class[0];
+            query.classes[i].push_back(symbol_class);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,197 @@
+#include "sdsl/wavelet_trees.hpp"
+#include "gtest/gtest.h"
+#include <vector>
+#include <string>
+#include <map>
+#include <queue>
+#include <random>
+
+namespace
+{
+
+using namespace sdsl;
+using namespace std;
+
+typedef int_vector<>::size_type size_type;
+typedef map<int_vector<>::value_type,size_type> tMII;
+
+string test_file;
+string temp_file;
+string temp_dir;
+
+template<class T>
+class wt_int_kary_test : public ::testing::Test { };
+
+using testing::Types;
+
+typedef Types<
+wt_int_kary<1>
+,wt_int_kary<2>
+,wt_int_kary<3>
+,wt_int_kary<4>
+> Implementations;
+
+TYPED_TEST_CASE(wt_int_kary_test, Implementations);
+
+//! Test the parametrized constructor
+TYPED_TEST(wt_int_kary_test, constructor)
+{
+    static_assert(sdsl::util::is_regular<TypeParam>::value, "Type is not regular");
+    int_vector<> iv;
+    load_from_file(iv, test_file);
+    double iv_size = size_in_mega_bytes(iv);
+    cout << "tc = " << test_file << endl;
+    {
+        TypeParam wt;
+        sdsl::construct(wt, test_file);
+        cout << "compression = " << size_in_mega_bytes(wt)/iv_size << endl;
+        ASSERT_EQ(iv.size(), wt.size());
+        set<uint64_t> sigma_set;
+        for (size_type j=0; j < iv.size(); ++j) {
+            ASSERT_EQ(iv[j], wt[j])<<j;
+            sigma_set.insert(iv[j]);
+        }
+        ASSERT_EQ(sigma_set.size(), wt.sigma);
+        ASSERT_TRUE(store_to_file(wt, temp_file));
+    }
+    {
+        int_vector_buffer<> iv_buf(test_file);
+        TypeParam wt(iv_buf, 0);
+        ASSERT_EQ((size_type)0,  wt.size());
+    }
+}
+
+//! Test the load method and rank method
+TYPED_TEST(wt_int_kary_test, load_and_rank)
+{
+    int_vector<> iv;
+    load_from_file(iv, test_file);
+    TypeParam wt;
+    ASSERT_TRUE(load_from_file(wt, temp_file));
+    ASSERT_EQ(iv.size(), wt.size());
+    tMII check_rank;
+    for (size_type j=0; j < iv.size(); ++j) {
+        ASSERT_EQ(wt.rank(j, iv[j]), check_rank[iv[j]]);
+        check_rank[iv[j]]++;
+    }
+    for (auto it=check_rank.begin(); it!=check_rank.end(); ++it) {
+        ASSERT_EQ(wt.rank(wt.size(), it->first), it->second);
+    }
+}
+
+//! Test the load method and select method
+TYPED_TEST(wt_int_kary_test, load_and_select)
+{
+    int_vector<> iv;
+    load_from_file(iv, test_file);
+    TypeParam wt;
+    ASSERT_TRUE(load_from_file(wt, temp_file));
+    ASSERT_EQ(iv.size(), wt.size());
+    tMII count;
+    for (size_type j=0; j < iv.size(); ++j) {
+        count[iv[j]]++;
+        ASSERT_EQ(j, wt.select(count[iv[j]], iv[j]))
+                << "iv[j]=" << iv[j] << " j="<<j;
+    }
+}
+
+//! Test the load method and inverse_select method
+TYPED_TEST(wt_int_kary_test, load_and_inverse_select)
+{
+    int_vector<> iv;
+    load_from_file(iv, test_file);
+    TypeParam wt;
+    ASSERT_TRUE(load_from_file(wt, temp_file));
+    ASSERT_EQ(iv.size(), wt.size());
+    tMII check_rank;
+    for (size_type j=0; j < iv.size(); ++j) {
+        auto rc = wt.inverse_select(j);
+        ASSERT_EQ(check_rank[iv[j]], rc.first);
+        ASSERT_EQ(iv[j], rc.second);
+        check_rank[iv[j]]++;
+    }
+}
+
+//! Test the k-way expand methods against the sequences of the nodes
+TYPED_TEST(wt_int_kary_test, expand)
+{
+    typedef typename TypeParam::node_type node_type;
+    int_vector<> iv;
+    load_from_file(iv, test_file);
+    TypeParam wt;
+    ASSERT_TRUE(load_from_file(wt, temp_file));
+    if (wt.size() < 1)
+        return;
+    mt19937_64 rng(7);
+    // nodes together with their sequences
+    std::queue<pair<node_type, vector<uint64_t>>> q;
+    q.emplace(wt.root(), vector<uint64_t>(iv.begin(), iv.end()));
+    for (size_t cnt = 0; !q.empty() and cnt < 1000; ++cnt) {
+        node_type x = q.front().first;
+        vector<uint64_t> seq = std::move(q.front().second);
+        q.pop();
+        ASSERT_EQ(seq.size(), wt.size(x));
+        if (wt.is_leaf(x)) {
+            for (auto c : seq)
+                ASSERT_EQ(wt.sym(x), c);
+            continue;
+        }
+        auto children = wt.expand(x);
+        ASSERT_EQ((size_t)TypeParam::arity, children.size());
+        std::vector<range_type> ranges = {{{0, seq.size()-1}}, {{0, (size_type)-1}}};
+        for (size_t i = 0; i < 4; ++i) {
+            size_type s = rng() % seq.size(), e = rng() % seq.size();
+            ranges.push_back({{std::min(s, e), std::max(s, e)}});
+        }
+        for (const auto& r : ranges) {
+            auto child_ranges = wt.expand(x, r);
+            auto fused = wt.expand_with_range(x, r);
+            for (size_t c = 0; c < children.size(); ++c) {
+                auto vr = wt.value_range(children[c]);
+                auto in_child = [&](uint64_t v) { return vr[0] <= v and v <= vr[1]; };
+                size_type sp = std::count_if(seq.begin(), seq.begin() + r[0], in_child);
+                size_type len = empty(r) ? 0 : std::count_if(seq.begin() + r[0], seq.begin() + r[1] + 1, in_child);
+                ASSERT_EQ(sp, child_ranges[c][0]);
+                ASSERT_EQ(len, child_ranges[c][1] - child_ranges[c][0] + 1);
+                ASSERT_TRUE(children[c] == fused[c].first);
+                ASSERT_EQ(wt.size(children[c]), wt.size(fused[c].first));
+                ASSERT_EQ(child_ranges[c], fused[c].second);
+            }
+        }
+        for (const auto& child : children) {
+            if (wt.empty(child))
+                continue;
+            auto vr = wt.value_range(child);
+            vector<uint64_t> child_seq;
+            std::copy_if(seq.begin(), seq.end(), std::back_inserter(child_seq), [&](uint64_t v) {
+                return vr[0] <= v and v <= vr[1];
+            });
+            q.emplace(child, std::move(child_seq));
+        }
+    }
+}
+
+TYPED_TEST(wt_int_kary_test, delete_)
+{
+    sdsl::remove(temp_file);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    if (argc < 4) {
+        // LCOV_EXCL_START
+        cout << "Usage: " << argv[0] << " test_file temp_file tmp_dir" << endl;
+        cout << " (1) Generates a WT out of test_file; stores it in temp_file." << endl;
+        cout << " (2) Performs tests." << endl;
+        cout << " (3) Deletes temp_file." << endl;
+        return 1;
+        // LCOV_EXCL_STOP
+    }
+    test_file = argv[1];
+    temp_file = argv[2];
+    temp_dir  = argv[3];
+    return RUN_ALL_TESTS();
+}
@@ -36,6 +36,8 @@ wt_blcd<bit_vector, rank_support_v<>, select_support_mcl<1>, select_support_mcl<
         ,wt_int<>
         ,wt_int<rrr_vector<15>>
         ,wt_int<rrr_vector<63>>
+        ,wt_int_dfs<>
+        ,wt_int_dfs<bit_vector_il<>, rank_support_il<>, select_support_il<1>, select_support_il<0>, 2>
         ,wt_rlmn<bit_vector, rank_support_v5<>, select_support_mcl<1>, wt_int<>>
         > Implementations;
 
@@ -587,6 +589,58 @@ TYPED_TEST(wt_int_test, nodes)
     test_nodes<TypeParam>(wt);
 }
 
+template<class t_wt>
+void
+test_expand_with_range(typename enable_if<!(has_node_type<t_wt>::value),t_wt>::type&)
+{
+    // not implemented
+}
+
+template<class t_wt>
+void
+test_expand_with_range(typename enable_if<has_node_type<t_wt>::value,t_wt>::type& wt)
+{
+    using node_type = typename t_wt::node_type;
+    ASSERT_TRUE(load_from_file(wt, temp_file));
+    if (wt.size() < 1)
+        return;
+    mt19937_64 rng(7);
+    std::queue<node_type> q;
+    q.push(wt.root());
+    for (size_t cnt = 0; !q.empty() and cnt < 10000; ++cnt) {
+        node_type x = q.front();
+        q.pop();
+        if (wt.is_leaf(x))
+            continue;
+        auto children = wt.expand(x);
+        auto x_size = wt.size(x);
+        std::vector<range_type> ranges = {{{0, x_size-1}}, {{0, (size_type)-1}}};
+        for (size_t i = 0; i < 4; ++i) {
+            size_type s = rng() % x_size, e = rng() % x_size;
+            ranges.push_back({{std::min(s, e), std::max(s, e)}});
+        }
+        for (const auto& r : ranges) {
+            auto child_ranges = wt.expand(x, r);
+            auto fused = wt.expand_with_range(x, r);
+            for (size_t i = 0; i < 2; ++i) {
+                ASSERT_TRUE(children[i] == fused[i].first);
+                ASSERT_EQ(wt.size(children[i]), wt.size(fused[i].first));
+                ASSERT_EQ(child_ranges[i], fused[i].second);
+            }
+        }
+        for (const auto& child : children)
+            if (!wt.empty(child))
+                q.emplace(child);
+    }
+}
+
+//! Test expand_with_range against expand
+TYPED_TEST(wt_int_test, expand_with_range)
+{
+    TypeParam wt;
+    test_expand_with_range<TypeParam>(wt);
+}
+
 template<class t_wt>
 void
 test_symbol_gte(typename enable_if<!(t_wt::lex_ordered), t_wt>::type&)